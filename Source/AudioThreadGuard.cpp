@@ -0,0 +1,108 @@
+#include "AudioThreadGuard.h"
+
+#if PLUCK_DETECT_AUDIO_THREAD_ALLOCATIONS && JUCE_DEBUG
+
+#include <cstdlib>
+#include <new>
+
+#if JUCE_WINDOWS
+ #include <malloc.h>
+#endif
+
+namespace
+{
+    thread_local bool audioThreadGuardActive = false;
+
+    void checkAudioThreadAllocation()
+    {
+        if (audioThreadGuardActive)
+        {
+            // The assertion itself may allocate
+            audioThreadGuardActive = false;
+            jassertfalse; // Allocation or deallocation on the audio thread
+            audioThreadGuardActive = true;
+        }
+    }
+
+    void* allocate(std::size_t size)
+    {
+        checkAudioThreadAllocation();
+
+        if (void* p = std::malloc(size == 0 ? 1 : size))
+            return p;
+
+        throw std::bad_alloc();
+    }
+
+    void deallocate(void* p) noexcept
+    {
+        if (p != nullptr)
+            checkAudioThreadAllocation();
+
+        std::free(p);
+    }
+
+    // Over-aligned types, e.g. SIMD registers in a std::vector. These blocks need their own free function on Windows.
+    void* allocateAligned(std::size_t size, std::align_val_t alignment)
+    {
+        checkAudioThreadAllocation();
+        const auto align = juce::jmax(static_cast<std::size_t>(alignment), sizeof(void*));
+
+       #if JUCE_WINDOWS
+        if (void* p = _aligned_malloc(size == 0 ? 1 : size, align))
+            return p;
+       #else
+        void* p = nullptr;
+        if (posix_memalign(&p, align, size == 0 ? 1 : size) == 0)
+            return p;
+       #endif
+
+        throw std::bad_alloc();
+    }
+
+    void deallocateAligned(void* p) noexcept
+    {
+        if (p != nullptr)
+            checkAudioThreadAllocation();
+
+       #if JUCE_WINDOWS
+        _aligned_free(p);
+       #else
+        std::free(p);
+       #endif
+    }
+}
+
+ScopedAudioThreadGuard::ScopedAudioThreadGuard() : wasActive(audioThreadGuardActive)
+{
+    audioThreadGuardActive = true;
+}
+
+ScopedAudioThreadGuard::~ScopedAudioThreadGuard()
+{
+    audioThreadGuardActive = wasActive;
+}
+
+void* operator new(std::size_t size)                                    { return allocate(size); }
+void* operator new[](std::size_t size)                                  { return allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept    { try { return allocate(size); } catch (...) { return nullptr; } }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept  { try { return allocate(size); } catch (...) { return nullptr; } }
+void operator delete(void* p) noexcept                                  { deallocate(p); }
+void operator delete[](void* p) noexcept                                { deallocate(p); }
+void operator delete(void* p, std::size_t) noexcept                     { deallocate(p); }
+void operator delete[](void* p, std::size_t) noexcept                   { deallocate(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept           { deallocate(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept         { deallocate(p); }
+
+void* operator new(std::size_t size, std::align_val_t alignment)                                    { return allocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment)                                  { return allocateAligned(size, alignment); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept    { try { return allocateAligned(size, alignment); } catch (...) { return nullptr; } }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept  { try { return allocateAligned(size, alignment); } catch (...) { return nullptr; } }
+void operator delete(void* p, std::align_val_t) noexcept                                            { deallocateAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept                                          { deallocateAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept                               { deallocateAligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept                             { deallocateAligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept                     { deallocateAligned(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept                   { deallocateAligned(p); }
+
+#endif
@@ -0,0 +1,20 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Debug aid: with PLUCK_DETECT_AUDIO_THREAD_ALLOCATIONS=1 in a debug build, the global
+// operator new/delete assert whenever they run inside a ScopedAudioThreadGuard.
+// Add the define to the Debug configuration's preprocessor definitions in the Projucer.
+#ifndef PLUCK_DETECT_AUDIO_THREAD_ALLOCATIONS
+ #define PLUCK_DETECT_AUDIO_THREAD_ALLOCATIONS 0
+#endif
+
+struct ScopedAudioThreadGuard
+{
+#if PLUCK_DETECT_AUDIO_THREAD_ALLOCATIONS && JUCE_DEBUG
+    ScopedAudioThreadGuard();
+    ~ScopedAudioThreadGuard();
+
+private:
+    bool wasActive;
+#endif
+};
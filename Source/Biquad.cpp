@@ -0,0 +1,102 @@
+#include "Biquad.h"
+#include <complex>
+
+BiquadCoefficients BiquadCoefficients::lowPass(double sampleRate, float frequency)
+{
+    const double n = 1.0 / std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+    const double nSquared = n * n;
+    const double invQ = juce::MathConstants<double>::sqrt2;
+    const double c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+    BiquadCoefficients c;
+    c.b0 = static_cast<float>(c1);
+    c.b1 = static_cast<float>(c1 * 2.0);
+    c.b2 = static_cast<float>(c1);
+    c.a1 = static_cast<float>(c1 * 2.0 * (1.0 - nSquared));
+    c.a2 = static_cast<float>(c1 * (1.0 - invQ * n + nSquared));
+    return c;
+}
+
+BiquadCoefficients BiquadCoefficients::highPass(double sampleRate, float frequency)
+{
+    const double n = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+    const double nSquared = n * n;
+    const double invQ = juce::MathConstants<double>::sqrt2;
+    const double c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+    BiquadCoefficients c;
+    c.b0 = static_cast<float>(c1);
+    c.b1 = static_cast<float>(c1 * -2.0);
+    c.b2 = static_cast<float>(c1);
+    c.a1 = static_cast<float>(c1 * 2.0 * (nSquared - 1.0));
+    c.a2 = static_cast<float>(c1 * (1.0 - invQ * n + nSquared));
+    return c;
+}
+
+BiquadCoefficients BiquadCoefficients::average()
+{
+    BiquadCoefficients c;
+    c.b0 = 0.5f;
+    c.b1 = 0.5f;
+    return c;
+}
+
+float BiquadCoefficients::getMagnitude(double sampleRate, float frequency) const
+{
+    const std::complex<double> z = std::polar(1.0, -juce::MathConstants<double>::twoPi * frequency / sampleRate);
+    const auto numerator = static_cast<double>(b0) + z * (static_cast<double>(b1) + z * static_cast<double>(b2));
+    const auto denominator = 1.0 + z * (static_cast<double>(a1) + z * static_cast<double>(a2));
+    return static_cast<float>(std::abs(numerator / denominator));
+}
+
+double BiquadCoefficients::getPhaseDelay(double sampleRate, double frequency) const
+{
+    const double omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+
+    if (omega <= 0.0)
+        return 0.0;
+
+    // Walk up from DC in steps small enough that the phase never jumps by more than pi between them
+    constexpr int steps = 16;
+    double phase = 0.0, previous = 0.0;
+
+    for (int step = 1; step <= steps; ++step)
+    {
+        const std::complex<double> z = std::polar(1.0, -omega * step / steps);
+        const auto numerator = static_cast<double>(b0) + z * (static_cast<double>(b1) + z * static_cast<double>(b2));
+        const auto denominator = 1.0 + z * (static_cast<double>(a1) + z * static_cast<double>(a2));
+        const double wrapped = std::arg(numerator / denominator);
+        phase += std::remainder(wrapped - previous, juce::MathConstants<double>::twoPi);
+        previous = wrapped;
+    }
+
+    return -phase / omega;
+}
+
+bool BiquadCoefficients::operator== (const BiquadCoefficients& other) const
+{
+    return b0 == other.b0 && b1 == other.b1 && b2 == other.b2 && a1 == other.a1 && a2 == other.a2;
+}
+
+void CoefficientCache::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    lastCutoff = -1.0f;
+}
+
+void CoefficientCache::prime(float cutoff, const BiquadCoefficients& designed)
+{
+    lastCutoff = cutoff;
+    coefficients = designed;
+}
+
+const BiquadCoefficients& CoefficientCache::get(float cutoff)
+{
+    if (cutoff != lastCutoff)
+    {
+        coefficients = design(sampleRate, cutoff);
+        lastCutoff = cutoff;
+    }
+
+    return coefficients;
+}
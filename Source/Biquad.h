@@ -0,0 +1,62 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Second-order section coefficients, normalised so a0 == 1.
+// Same designs as juce::dsp::IIR::Coefficients, computed in place with no allocation.
+struct BiquadCoefficients
+{
+    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+
+    static BiquadCoefficients lowPass(double sampleRate, float frequency);
+    static BiquadCoefficients highPass(double sampleRate, float frequency);
+
+    // The classic Karplus-Strong loop filter, (x[n] + x[n-1]) / 2
+    static BiquadCoefficients average();
+
+    // Gain of the filter at one frequency
+    float getMagnitude(double sampleRate, float frequency) const;
+
+    // Phase delay in samples at one frequency, with the phase unwrapped from DC
+    double getPhaseDelay(double sampleRate, double frequency) const;
+
+    bool operator== (const BiquadCoefficients& other) const;
+    bool operator!= (const BiquadCoefficients& other) const    { return ! (*this == other); }
+};
+
+// Transposed direct form II state
+struct BiquadState
+{
+    float z1 = 0.0f, z2 = 0.0f;
+
+    float processSample(const BiquadCoefficients& c, float in)
+    {
+        const float out = c.b0 * in + z1;
+        z1 = c.b1 * in - c.a1 * out + z2;
+        z2 = c.b2 * in - c.a2 * out;
+        return out;
+    }
+
+    void reset() { z1 = z2 = 0.0f; }
+};
+
+// Keeps the coefficients for the last cutoff and only redesigns when it changes.
+// Owned and used by a single thread, so it needs no locking.
+class CoefficientCache
+{
+public:
+    using Design = BiquadCoefficients (*)(double, float);
+
+    explicit CoefficientCache(Design designToUse) : design(designToUse) {}
+
+    void prepare(double newSampleRate);
+    const BiquadCoefficients& get(float cutoff);
+
+    // Hands over coefficients designed elsewhere for this cutoff, at this cache's sample rate
+    void prime(float cutoff, const BiquadCoefficients& designed);
+
+private:
+    Design design;
+    double sampleRate = 44100.0;
+    float lastCutoff = -1.0f;
+    BiquadCoefficients coefficients;
+};
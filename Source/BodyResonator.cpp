@@ -0,0 +1,461 @@
+#include "BodyResonator.h"
+#include "RealtimeSemaphore.h"
+
+namespace
+{
+    struct BodyMode
+    {
+        float frequency, decaySeconds, gain;
+    };
+
+    // A few prominent low resonances, then a dense random spread of weaker, faster-decaying modes
+    struct BodyDesign
+    {
+        float seconds;
+        BodyMode modes[6];
+        int numDenseModes;
+        float denseLow, denseHigh;
+        float denseDecayLow, denseDecayHigh;
+        float denseGain;
+        juce::int64 seed;
+    };
+
+    const BodyDesign bodyDesigns[] =
+    {
+        // none
+        { 0.0f, {}, 0, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0 },
+
+        // guitar: Helmholtz air mode, then the first top and back plate modes
+        { 0.4f, { { 100.0f, 0.25f, 1.0f }, { 204.0f, 0.2f, 0.9f }, { 245.0f, 0.15f, 0.6f },
+                  { 390.0f, 0.12f, 0.5f }, { 550.0f, 0.1f, 0.4f }, { 700.0f, 0.08f, 0.3f } },
+          60, 800.0f, 6000.0f, 0.08f, 0.02f, 0.25f, 1 },
+
+        // piano: a large soundboard, many long and closely spaced modes
+        { 1.0f, { { 55.0f, 0.9f, 0.6f }, { 110.0f, 0.8f, 0.6f }, { 180.0f, 0.7f, 0.5f },
+                  { 260.0f, 0.6f, 0.5f }, { 350.0f, 0.5f, 0.4f }, { 480.0f, 0.45f, 0.4f } },
+          100, 500.0f, 5000.0f, 0.5f, 0.1f, 0.3f, 2 },
+
+        // harp: a light, bright soundbox
+        { 0.6f, { { 140.0f, 0.35f, 1.0f }, { 290.0f, 0.3f, 0.7f }, { 430.0f, 0.25f, 0.5f },
+                  { 610.0f, 0.2f, 0.4f }, { 820.0f, 0.15f, 0.3f }, { 1100.0f, 0.12f, 0.25f } },
+          60, 1200.0f, 7000.0f, 0.12f, 0.03f, 0.2f, 3 }
+    };
+
+    static_assert(std::size(bodyDesigns) == BodyResonator::numBodies, "One design per body");
+
+    // Adds an exponentially decaying sine, rotated recursively instead of calling sin per sample
+    void addMode(std::vector<float>& taps, double sampleRate, const BodyMode& mode)
+    {
+        if (mode.gain <= 0.0f || mode.frequency >= 0.45 * sampleRate)
+            return;
+
+        const double radius = std::exp(-6.907755 / (mode.decaySeconds * sampleRate)); // -60 dB after decaySeconds
+        const double angle = juce::MathConstants<double>::twoPi * mode.frequency / sampleRate;
+        const double c = radius * std::cos(angle), s = radius * std::sin(angle);
+        double re = 1.0, im = 0.0;
+
+        for (auto& tap : taps)
+        {
+            tap += static_cast<float>(mode.gain * im);
+            const double next = re * c - im * s;
+            im = re * s + im * c;
+            re = next;
+        }
+    }
+}
+
+class BodyResonator::TailThread : public juce::Thread
+{
+public:
+    enum State
+    {
+        idle,
+        queued,
+        running
+    };
+
+    TailThread() : juce::Thread("Pluck body tail")
+    {
+    }
+
+    // Only touched by whoever holds the convolver: the tail thread while running, the audio thread otherwise
+    PartitionedConvolver convolver;
+    std::vector<float> input, output;
+
+    void submit()
+    {
+        state.store(queued, std::memory_order_release);
+        wakeUp.signal();
+    }
+
+    // Audio thread: takes the convolver back unless the tail thread is in the middle of a block.
+    // Returns the state it was taken from, a queued block is left for the caller to compute.
+    int claim()
+    {
+        int expected = queued;
+        state.compare_exchange_strong(expected, idle, std::memory_order_acq_rel, std::memory_order_acquire);
+        return expected;
+    }
+
+    // Audio thread: applied at once if the convolver can be claimed, otherwise before the next block
+    void setImpulse(const PartitionedConvolver::Impulse* impulse)
+    {
+        pendingImpulse.store(impulse, std::memory_order_release);
+
+        if (claim() != running)
+            applyPending();
+    }
+
+    void reset()
+    {
+        pendingReset.store(true, std::memory_order_release);
+
+        if (claim() != running)
+            applyPending();
+    }
+
+    void compute()
+    {
+        applyPending();
+        convolver.process(input.data(), output.data());
+    }
+
+    void stop()
+    {
+        signalThreadShouldExit();
+        wakeUp.signal();
+        stopThread(1000);
+        state.store(idle, std::memory_order_release);
+    }
+
+    void run() override
+    {
+        juce::ScopedNoDenormals noDenormals;
+
+        while (!threadShouldExit())
+        {
+            wakeUp.wait();
+
+            int expected = queued;
+            if (!state.compare_exchange_strong(expected, running, std::memory_order_acq_rel, std::memory_order_acquire))
+                continue;
+
+            compute();
+            state.store(idle, std::memory_order_release);
+        }
+    }
+
+private:
+    void applyPending()
+    {
+        if (auto* impulse = pendingImpulse.exchange(nullptr, std::memory_order_acq_rel))
+            convolver.setImpulse(impulse);
+
+        if (pendingReset.exchange(false, std::memory_order_acq_rel))
+            convolver.reset();
+    }
+
+    RealtimeSemaphore wakeUp;
+    std::atomic<int> state { idle };
+    std::atomic<const PartitionedConvolver::Impulse*> pendingImpulse { nullptr };
+    std::atomic<bool> pendingReset { false };
+};
+
+BodyResonator::BodyResonator()
+    : tail(std::make_unique<TailThread>())
+{
+}
+
+BodyResonator::~BodyResonator()
+{
+    release();
+}
+
+const juce::StringArray& BodyResonator::getBodyNames()
+{
+    static const juce::StringArray names { "Off", "Guitar", "Piano", "Harp" };
+    return names;
+}
+
+float BodyResonator::getImpulseSeconds(int body)
+{
+    return juce::isPositiveAndBelow(body, static_cast<int>(numBodies)) ? bodyDesigns[body].seconds : 0.0f;
+}
+
+void BodyResonator::designImpulse(int body, double sampleRate, std::vector<float>& taps)
+{
+    const auto& design = bodyDesigns[body];
+    taps.assign(static_cast<size_t>(design.seconds * sampleRate), 0.0f);
+
+    if (taps.empty())
+        return;
+
+    for (auto& mode : design.modes)
+        addMode(taps, sampleRate, mode);
+
+    // Log-spaced at random, seeded, so every instance builds the same impulse
+    juce::Random random(design.seed);
+
+    for (int i = 0; i < design.numDenseModes; ++i)
+    {
+        const float position = random.nextFloat();
+        const float frequency = design.denseLow * std::pow(design.denseHigh / design.denseLow, position);
+        const float decay = design.denseDecayLow + (design.denseDecayHigh - design.denseDecayLow) * position;
+        addMode(taps, sampleRate, { frequency, decay, design.denseGain * (0.5f + 0.5f * random.nextFloat()) });
+    }
+
+    // Fade out the last tenth so the truncation doesn't click, then normalise to unit energy
+    const int fadeLength = juce::jmax(1, static_cast<int>(taps.size()) / 10);
+    const int fadeStart = static_cast<int>(taps.size()) - fadeLength;
+
+    for (int i = 0; i < fadeLength; ++i)
+        taps[static_cast<size_t>(fadeStart + i)] *= 0.5f + 0.5f * std::cos(juce::MathConstants<float>::pi * static_cast<float>(i) / static_cast<float>(fadeLength));
+
+    double energy = 0.0;
+    for (auto tap : taps)
+        energy += static_cast<double>(tap) * tap;
+
+    if (energy > 0.0)
+        juce::FloatVectorOperations::multiply(taps.data(), static_cast<float>(1.0 / std::sqrt(energy)), static_cast<int>(taps.size()));
+}
+
+std::shared_ptr<const BodyResonator::ImpulseSet> BodyResonator::designImpulses(double sampleRate)
+{
+    auto set = std::make_shared<ImpulseSet>();
+    set->sampleRate = sampleRate;
+    std::vector<float> taps[numBodies];
+
+    for (int b = 0; b < numBodies; ++b)
+    {
+        designImpulse(b, sampleRate, taps[b]);
+        const int length = static_cast<int>(taps[b].size());
+        set->maxLatePartitions = juce::jmax(set->maxLatePartitions, (length - tailStart + tailBlockSize - 1) / tailBlockSize);
+    }
+
+    // Spectra come out of convolvers set up like the ones that will use them
+    PartitionedConvolver early, late;
+    early.prepare(headLength, (tailStart - headLength) / headLength);
+    late.prepare(tailBlockSize, set->maxLatePartitions);
+
+    // head | early stage from headLength | late stage from tailStart
+    for (int b = 0; b < numBodies; ++b)
+    {
+        auto& impulse = set->bodies[b];
+        const int length = static_cast<int>(taps[b].size());
+        const float* data = taps[b].data();
+
+        impulse.length = length;
+        impulse.head.assign(data, data + juce::jmin(length, static_cast<int>(headLength)));
+        early.makeImpulse(data + juce::jmin(length, static_cast<int>(headLength)), juce::jlimit(0, tailStart - headLength, length - headLength), impulse.early);
+        late.makeImpulse(data + juce::jmin(length, static_cast<int>(tailStart)), juce::jmax(0, length - tailStart), impulse.late);
+    }
+
+    return set;
+}
+
+void BodyResonator::prepare(std::shared_ptr<const ImpulseSet> newImpulses)
+{
+    release();
+
+    // Preparing the convolvers drops their pointers into the previous set before it can go,
+    // and so does a body change the stopped thread never picked up
+    tail->setImpulse(nullptr);
+    early.prepare(headLength, (tailStart - headLength) / headLength);
+    tail->convolver.prepare(tailBlockSize, newImpulses->maxLatePartitions);
+    impulses = std::move(newImpulses);
+
+    headHistory.assign(static_cast<size_t>(2 * headLength - 1), 0.0f);
+    earlyInput.assign(static_cast<size_t>(headLength), 0.0f);
+    earlyOutput.assign(static_cast<size_t>(headLength), 0.0f);
+    wet.assign(static_cast<size_t>(headLength), 0.0f);
+
+    for (auto* block : { &tailInput, &tailOutput, &lateInput, &tail->input, &tail->output })
+        block->assign(static_cast<size_t>(tailBlockSize), 0.0f);
+
+    tailOverruns = 0;
+
+    // Scheduled like the audio thread, with a whole tail block of audio time per block it computes
+    const auto options = juce::Thread::RealtimeOptions {}.withApproximateAudioProcessingTime(tailBlockSize, impulses->sampleRate);
+
+    if (!tail->startRealtimeThread(options))
+        tail->startThread(juce::Thread::Priority::highest);
+
+    const int previousBody = body;
+    body = none;
+    reset();
+    setBody(previousBody);
+}
+
+void BodyResonator::release()
+{
+    tail->stop();
+}
+
+void BodyResonator::setNonRealtime(bool shouldComputeTailInline)
+{
+    nonRealtime = shouldComputeTailInline;
+}
+
+void BodyResonator::reset()
+{
+    early.reset();
+    tail->reset();
+    discardTail = true;
+    lateBlock = false;
+
+    for (auto* block : { &headHistory, &earlyOutput, &tailOutput })
+        std::fill(block->begin(), block->end(), 0.0f);
+
+    earlyFill = 0;
+    tailFill = 0;
+    quietSamples = impulseLength + tailBlockSize + 1;
+}
+
+void BodyResonator::setBody(int newBody)
+{
+    newBody = juce::jlimit(0, numBodies - 1, newBody);
+
+    if (newBody == body)
+        return;
+
+    body = newBody;
+    impulseLength = impulses->bodies[body].length;
+    early.setImpulse(&impulses->bodies[body].early);
+    tail->setImpulse(&impulses->bodies[body].late);
+    reset();
+}
+
+void BodyResonator::process(float* samples, const float* wetMix, int numSamples)
+{
+    if (body == none)
+        return;
+
+    const auto inputRange = juce::FloatVectorOperations::findMinAndMax(samples, numSamples);
+    const float inputPeak = juce::jmax(-inputRange.getStart(), inputRange.getEnd());
+
+    // Nothing in and the last input has rung out, so the dry signal passes unchanged
+    if (inputPeak < sleepThreshold)
+    {
+        if (isQuiet())
+            return;
+
+        quietSamples += numSamples;
+
+        if (isQuiet())
+        {
+            reset();
+            return;
+        }
+    }
+    else
+    {
+        quietSamples = 0;
+    }
+
+    const bool hasTail = impulses->bodies[body].late.numPartitions > 0;
+
+    // Chunks end on short partition boundaries, which include every tail boundary
+    for (int done = 0; done < numSamples;)
+    {
+        const int n = juce::jmin(numSamples - done, headLength - earlyFill);
+        float* x = samples + done;
+
+        // Body output: the direct head plus what the partitioned stages computed for this stretch
+        juce::FloatVectorOperations::copy(wet.data(), earlyOutput.data() + earlyFill, n);
+        juce::FloatVectorOperations::add(wet.data(), tailOutput.data() + tailFill, n);
+        processHead(x, wet.data(), n);
+
+        juce::FloatVectorOperations::copy(earlyInput.data() + earlyFill, x, n);
+        juce::FloatVectorOperations::copy(tailInput.data() + tailFill, x, n);
+
+        // x += (wet - x) * mix
+        juce::FloatVectorOperations::subtract(wet.data(), x, n);
+        juce::FloatVectorOperations::multiply(wet.data(), wetMix + done, n);
+        juce::FloatVectorOperations::add(x, wet.data(), n);
+
+        earlyFill += n;
+        tailFill += n;
+        done += n;
+
+        if (earlyFill == headLength)
+        {
+            early.process(earlyInput.data(), earlyOutput.data());
+            earlyFill = 0;
+        }
+
+        if (tailFill == tailBlockSize)
+        {
+            if (hasTail)
+                exchangeTail();
+
+            tailFill = 0;
+        }
+    }
+}
+
+void BodyResonator::processHead(const float* in, float* out, int numSamples)
+{
+    // Transposed direct form: one vector multiply-add per tap over the whole chunk
+    float* history = headHistory.data();
+    std::copy(in, in + numSamples, history + headLength - 1);
+
+    const auto& head = impulses->bodies[body].head;
+    for (int tap = 0; tap < static_cast<int>(head.size()); ++tap)
+        juce::FloatVectorOperations::addWithMultiply(out, history + headLength - 1 - tap, head[static_cast<size_t>(tap)], numSamples);
+
+    std::copy(history + numSamples, history + numSamples + headLength - 1, history);
+}
+
+void BodyResonator::exchangeTail()
+{
+    // The block submitted one tail block ago becomes the output for the next one. The thread has had a whole
+    // block to finish it. If it never started, it is computed here. The audio thread never waits for it.
+    const int previous = tail->claim();
+
+    // Still running: the next tail block stays silent rather than playing the last one again. This block's input
+    // is held back for the next exchange. A second overrun in a row drops it, and the tail restarts from silence.
+    if (previous == TailThread::running)
+    {
+        ++tailOverruns;
+        std::fill(tailOutput.begin(), tailOutput.end(), 0.0f);
+
+        if (lateBlock)
+        {
+            tail->reset();
+            discardTail = true;
+            lateBlock = false;
+        }
+        else
+        {
+            std::swap(tailInput, lateInput);
+            lateBlock = true;
+        }
+
+        return;
+    }
+
+    if (previous == TailThread::queued)
+        tail->compute();
+
+    // After an overrun the finished block is too late to play. The held-back block's output is due now.
+    if (lateBlock)
+    {
+        std::swap(tail->input, lateInput);
+        tail->compute();
+        lateBlock = false;
+    }
+
+    // Computed from history a reset has since cleared
+    if (discardTail)
+        std::fill(tail->output.begin(), tail->output.end(), 0.0f);
+
+    std::swap(tailOutput, tail->output);
+    std::swap(tailInput, tail->input);
+    discardTail = false;
+
+    // Rendering offline, the thread could fall a block behind, so the tail stays on this thread
+    if (nonRealtime)
+        tail->compute();
+    else
+        tail->submit();
+}
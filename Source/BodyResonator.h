@@ -0,0 +1,95 @@
+#pragma once
+#include <JuceHeader.h>
+#include "PartitionedConvolver.h"
+
+// Instrument body stage after the voice mix: convolution with one of a few built-in body impulses.
+// Non-uniform partitioning keeps it free of latency and cheap. The first headLength taps run as a
+// direct FIR, the next stretch in short FFT partitions on the audio thread, and the long tail in
+// large partitions on a real-time background thread, which has a whole tail block of time to deliver.
+// The audio thread never waits for it: a block it hasn't started is computed inline instead, and a block
+// it is still working on leaves the next tail block silent and is counted as an overrun.
+class BodyResonator
+{
+public:
+    enum Body
+    {
+        none = 0,
+        guitar,
+        piano,
+        harp,
+        numBodies
+    };
+
+    static constexpr int headLength = 128;                 // Direct taps, also the short partition size
+    static constexpr int tailBlockSize = 1024;             // Partition size of the background stage
+    static constexpr int tailStart = 2 * tailBlockSize;    // First tap of the background stage
+    static constexpr float sleepThreshold = 1.0e-6f;
+
+    BodyResonator();
+    ~BodyResonator();
+
+    static const juce::StringArray& getBodyNames();
+    static float getImpulseSeconds(int body);
+
+    // Every body's impulse at one sample rate, read-only once designed, so instances can share it
+    struct ImpulseSet
+    {
+        struct Impulses
+        {
+            std::vector<float> head;                      // First taps in order, the FIR reads the history backwards
+            PartitionedConvolver::Impulse early, late;
+            int length = 0;
+        };
+
+        Impulses bodies[numBodies];
+        int maxLatePartitions = 1;
+        double sampleRate = 44100.0;
+    };
+
+    // Not real-time safe
+    static std::shared_ptr<const ImpulseSet> designImpulses(double sampleRate);
+
+    // Takes the impulses designed for the new rate and starts the tail thread, not real-time safe
+    void prepare(std::shared_ptr<const ImpulseSet> newImpulses);
+    void release();
+    void reset();
+
+    // Changing body clears the history, the tail thread picks the change up before its next block
+    void setBody(int newBody);
+
+    // Offline rendering keeps the tail on the calling thread, so no block can miss
+    void setNonRealtime(bool shouldComputeTailInline);
+
+    // samples = dry + (body - dry) * wetMix, in place
+    void process(float* samples, const float* wetMix, int numSamples);
+
+    bool isQuiet() const    { return body == none || quietSamples > impulseLength + tailBlockSize; }
+
+    // Tail blocks the background thread delivered too late to play, since prepare
+    int getTailOverruns() const { return tailOverruns; }
+
+private:
+    class TailThread;
+
+    static void designImpulse(int body, double sampleRate, std::vector<float>& taps);
+    void processHead(const float* in, float* out, int numSamples);
+    void exchangeTail();
+
+    std::shared_ptr<const ImpulseSet> impulses;
+    PartitionedConvolver early;
+    std::unique_ptr<TailThread> tail;
+
+    std::vector<float> headHistory;     // headLength - 1 past samples followed by the current chunk
+    std::vector<float> earlyInput, earlyOutput;
+    std::vector<float> tailInput, tailOutput;
+    std::vector<float> lateInput;       // Input of the block an overrun held back, caught up at the next exchange
+    std::vector<float> wet;
+    int earlyFill = 0, tailFill = 0;
+    int tailOverruns = 0;
+    bool discardTail = false, lateBlock = false, nonRealtime = false;
+    int body = none;
+    int impulseLength = 0;
+    int quietSamples = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(BodyResonator)
+};
@@ -0,0 +1,45 @@
+#include "ControlRamp.h"
+
+void ControlRamp::prepare(double sampleRate, int maxBlockSize, double rampSeconds, float initialValue)
+{
+    smoothed.reset(sampleRate, rampSeconds);
+    smoothed.setCurrentAndTargetValue(initialValue);
+    currentValue = initialValue;
+    ramp.assign(static_cast<size_t>(juce::jmax(1, maxBlockSize)), initialValue);
+}
+
+void ControlRamp::setCurrentAndTargetValue(float newValue)
+{
+    smoothed.setCurrentAndTargetValue(newValue);
+    currentValue = newValue;
+}
+
+const float* ControlRamp::process(int numSamples)
+{
+    // The processor splits blocks longer than prepare announced, so this never has to grow on the audio thread
+    jassert(static_cast<size_t>(numSamples) <= ramp.size());
+    numSamples = juce::jmin(numSamples, static_cast<int>(ramp.size()));
+
+    float* out = ramp.data();
+
+    if (!smoothed.isSmoothing())
+    {
+        currentValue = smoothed.getTargetValue();
+        juce::FloatVectorOperations::fill(out, currentValue, numSamples);
+        return out;
+    }
+
+    for (int start = 0; start < numSamples; start += controlInterval)
+    {
+        const int n = juce::jmin(controlInterval, numSamples - start);
+        const float nextValue = smoothed.skip(n);
+        const float step = (nextValue - currentValue) / static_cast<float>(n);
+
+        for (int i = 0; i < n; ++i)
+            out[start + i] = currentValue + step * static_cast<float>(i + 1);
+
+        currentValue = nextValue;
+    }
+
+    return out;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <JuceHeader.h>
+
+// A smoothed parameter evaluated every controlInterval samples and linearly interpolated in between,
+// so it can be applied to a block with vector multiplies.
+class ControlRamp
+{
+public:
+    static constexpr int defaultControlInterval = 32;
+
+    void prepare(double sampleRate, int maxBlockSize, double rampSeconds, float initialValue);
+    void setTargetValue(float newValue) { smoothed.setTargetValue(newValue); }
+    void setCurrentAndTargetValue(float newValue);
+    void setControlInterval(int newInterval) { controlInterval = juce::jmax(1, newInterval); }
+
+    // Fills and returns numSamples of ramp, at most the maxBlockSize given to prepare
+    const float* process(int numSamples);
+
+private:
+    juce::SmoothedValue<float> smoothed;
+    std::vector<float> ramp;
+    float currentValue = 0.0f;
+    int controlInterval = defaultControlInterval;
+};
@@ -0,0 +1,43 @@
+#include "DelayLinePool.h"
+
+int DelayLinePool::getLineLength(double sampleRate)
+{
+    // Longest loop plus the three samples the interpolator reads behind it
+    const int longestLoop = static_cast<int>(std::ceil(sampleRate / lowestNoteHz)) + 4;
+    return juce::nextPowerOfTwo(longestLoop);
+}
+
+void DelayLinePool::prepare(int newNumLines, int newLineLength, int newFormat)
+{
+    jassert(juce::isPowerOfTwo(newLineLength));
+
+    // Same shape as before. A voice clears the part of its line it reads at every note-on, so the old samples
+    // can stay, and lines no voice has played stay untouched instead of being paged in just to be zeroed.
+    if (newNumLines == numLines && newLineLength == lineLength && newFormat == format && lines != nullptr)
+        return;
+
+    numLines = newNumLines;
+    lineLength = newLineLength;
+    format = newFormat;
+
+    // Over-allocate by one cache line so the first line can be aligned. Zero bits are 0.0 in both formats.
+    memory.calloc(getSizeInBytes() + alignment);
+    lines = juce::snapPointerToAlignment(memory.get(), alignment);
+}
+
+float* DelayLinePool::getLine(int index) const
+{
+    jassert(format == full && juce::isPositiveAndBelow(index, numLines));
+    return reinterpret_cast<float*>(lines + static_cast<size_t>(index) * getLineBytes());
+}
+
+juce::uint16* DelayLinePool::getHalfLine(int index) const
+{
+    jassert(format == half && juce::isPositiveAndBelow(index, numLines));
+    return reinterpret_cast<juce::uint16*>(lines + static_cast<size_t>(index) * getLineBytes());
+}
+
+size_t DelayLinePool::getSizeInBytes() const
+{
+    return static_cast<size_t>(numLines) * getLineBytes();
+}
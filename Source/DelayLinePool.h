@@ -0,0 +1,41 @@
+#pragma once
+#include <JuceHeader.h>
+
+// All voices' delay lines in one contiguous, cache-line aligned block.
+// Each line is a power of two long enough for the lowest playable note, so positions wrap with a mask.
+// Lines hold floats, or half floats to halve the memory the string loops stream through.
+// A float line is 8 KB at 44.1 and 48 kHz, 16 KB at 88.2 and 96 kHz and 32 KB at 192 kHz, so the 132 lines the
+// processor reserves take about 1, 2 or 4 MB of address space. Only lines a voice has played are ever touched,
+// and the allocator takes the lowest free voice, so what a session keeps in cache is its polyphony plus the
+// steal headroom, not the whole pool.
+class DelayLinePool
+{
+public:
+    enum Format
+    {
+        full = 0,   // float
+        half        // IEEE half float, see HalfFloat
+    };
+
+    // A0, MIDI note 21. Lower notes are clamped to this loop length by the tuning table.
+    static constexpr double lowestNoteHz = 27.5;
+    static constexpr size_t alignment = 64;
+
+    static int getLineLength(double sampleRate);
+
+    void prepare(int numLines, int lineLength, int format = full);
+
+    float* getLine(int index) const;
+    juce::uint16* getHalfLine(int index) const;
+    int getLineLength() const    { return lineLength; }
+    int getNumLines() const      { return numLines; }
+    int getFormat() const        { return format; }
+    size_t getSizeInBytes() const;
+
+private:
+    size_t getLineBytes() const  { return static_cast<size_t>(lineLength) * (format == half ? sizeof(juce::uint16) : sizeof(float)); }
+
+    juce::HeapBlock<char> memory;
+    char* lines = nullptr;
+    int numLines = 0, lineLength = 0, format = full;
+};
@@ -0,0 +1,162 @@
+#include "DspKernels.h"
+#include "HalfFloat.h"
+#include <juce_dsp/juce_dsp.h>
+
+namespace
+{
+    using Register = juce::dsp::SIMDRegister<float>;
+    constexpr int registerLanes = static_cast<int>(Register::SIMDNumElements);
+
+    // SSE2 on x86, NEON on ARM: whatever juce::dsp::SIMDRegister maps to in the baseline build.
+    // Neither has half float conversions, so half lines are converted one lane at a time.
+    template <bool halfLines>
+    void renderVoicesBaseline(VoiceLanes& v, float* out, int numSamples)
+    {
+        constexpr int lanes = registerLanes;
+        alignas(Register::SIMDRegisterSize) float x0[lanes], x1[lanes], x2[lanes], x3[lanes], excitation[lanes], written[lanes], stored[lanes];
+
+        const auto H0 = Register::fromRawArray(v.h0), H1 = Register::fromRawArray(v.h1);
+        const auto H2 = Register::fromRawArray(v.h2), H3 = Register::fromRawArray(v.h3);
+        const auto G = Register::fromRawArray(v.g);
+        const auto B0 = Register::fromRawArray(v.b0), B1 = Register::fromRawArray(v.b1), B2 = Register::fromRawArray(v.b2);
+        const auto A1 = Register::fromRawArray(v.a1), A2 = Register::fromRawArray(v.a2);
+        const auto Decay = Register::fromRawArray(v.decay), GainStep = Register::fromRawArray(v.gainStep);
+        const auto Zero = Register::expand(0.0f);
+        auto State = Register::fromRawArray(v.state);
+        auto Z1 = Register::fromRawArray(v.z1), Z2 = Register::fromRawArray(v.z2);
+        auto Gain = Register::fromRawArray(v.gain);
+        auto Energy = Zero;
+        auto RoundingError = Register::fromRawArray(v.roundingError);
+        const auto MaxValue = Register::expand(HalfFloat::maxValue), MinValue = Register::expand(-HalfFloat::maxValue);
+
+        for (int sample = 0; sample < numSamples; ++sample)
+        {
+            // Delay taps and exciters are per lane
+            for (int lane = 0; lane < lanes; ++lane)
+            {
+                const int read = v.readPosition[lane];
+                const int m = v.mask[lane];
+
+                if constexpr (halfLines)
+                {
+                    const juce::uint16* data = v.halfData[lane];
+                    x0[lane] = HalfFloat::toFloat(data[read]);
+                    x1[lane] = HalfFloat::toFloat(data[(read - 1) & m]);
+                    x2[lane] = HalfFloat::toFloat(data[(read - 2) & m]);
+                    x3[lane] = HalfFloat::toFloat(data[(read - 3) & m]);
+                }
+                else
+                {
+                    const float* data = v.delayData[lane];
+                    x0[lane] = data[read];
+                    x1[lane] = data[(read - 1) & m];
+                    x2[lane] = data[(read - 2) & m];
+                    x3[lane] = data[(read - 3) & m];
+                }
+
+                excitation[lane] = v.excitationPosition[lane] < v.excitationLength[lane] ? v.excitation[lane][v.excitationPosition[lane]++] : 0.0f;
+            }
+
+            // Fractional delays and feedback filters of every lane at once
+            const auto X = H0 * Register::fromRawArray(x0) + H1 * Register::fromRawArray(x1)
+                         + H2 * Register::fromRawArray(x2) + H3 * Register::fromRawArray(x3) - G * State;
+            State = X;
+
+            const auto Y = B0 * X + Z1;
+            Z1 = B1 * X - A1 * Y + Z2;
+            Z2 = B2 * X - A2 * Y;
+
+            const auto Written = Register::fromRawArray(excitation) + Y * Decay;
+
+            if constexpr (halfLines)
+            {
+                // Noise-shaped rounding, the error of each lane carries over to its next sample
+                const auto Shaped = Register::min(MaxValue, Register::max(MinValue, Written + RoundingError));
+                Shaped.copyToRawArray(written);
+
+                for (int lane = 0; lane < lanes; ++lane)
+                {
+                    const auto half = HalfFloat::fromFloat(written[lane]);
+                    v.halfData[lane][v.writePosition[lane]] = half;
+                    stored[lane] = HalfFloat::toFloat(half);
+                }
+
+                RoundingError = Shaped - Register::fromRawArray(stored);
+            }
+            else
+            {
+                Written.copyToRawArray(written);
+
+                for (int lane = 0; lane < lanes; ++lane)
+                    v.delayData[lane][v.writePosition[lane]] = written[lane];
+            }
+
+            for (int lane = 0; lane < lanes; ++lane)
+            {
+                v.readPosition[lane] = (v.readPosition[lane] + 1) & v.mask[lane];
+                v.writePosition[lane] = (v.writePosition[lane] + 1) & v.mask[lane];
+            }
+
+            const auto Output = Y * Gain;
+            Gain = Register::max(Zero, Gain + GainStep);
+            Energy += Output * Output;
+            out[sample] += Output.sum();
+        }
+
+        State.copyToRawArray(v.state);
+        Z1.copyToRawArray(v.z1);
+        Z2.copyToRawArray(v.z2);
+        Gain.copyToRawArray(v.gain);
+        RoundingError.copyToRawArray(v.roundingError);
+        (Energy * (1.0f / static_cast<float>(juce::jmax(1, numSamples)))).copyToRawArray(v.energy);
+    }
+
+    void multiplyBaseline(float* samples, const float* gain, int numSamples)
+    {
+        juce::FloatVectorOperations::multiply(samples, gain, numSamples);
+    }
+}
+
+namespace KernelVariants
+{
+    const DspKernels baselineKernels { "baseline", registerLanes, renderVoicesBaseline<false>, renderVoicesBaseline<true>, multiplyBaseline };
+}
+
+bool DspKernels::isAvailable(int isa)
+{
+   #if PLUCK_X86_KERNELS
+    // The AVX2 loop filter uses fused multiply-adds
+    if (isa == avx2)
+        return juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3();
+
+    if (isa == avx512)
+        return juce::SystemStats::hasAVX512F();
+   #endif
+
+    return isa == baseline;
+}
+
+int DspKernels::detectIsa()
+{
+    for (int isa = numIsas - 1; isa > baseline; --isa)
+        if (isAvailable(isa))
+            return isa;
+
+    return baseline;
+}
+
+const DspKernels& DspKernels::get(int isa)
+{
+    if (! isAvailable(isa))
+        return KernelVariants::baselineKernels;
+
+   #if PLUCK_X86_KERNELS
+    if (isa == avx2)
+        return KernelVariants::avx2Kernels;
+
+    if (isa == avx512)
+        return KernelVariants::avx512Kernels;
+   #endif
+
+    return KernelVariants::baselineKernels;
+}
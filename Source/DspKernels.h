@@ -0,0 +1,76 @@
+#pragma once
+#include <JuceHeader.h>
+
+// x86 builds carry AVX2 and AVX-512 variants of the kernels next to the baseline ones.
+// They are compiled per function with target attributes, so no project-wide flags are needed.
+#if JUCE_INTEL && ! defined (PLUCK_NO_ISA_DISPATCH)
+ #define PLUCK_X86_KERNELS 1
+#else
+ #define PLUCK_X86_KERNELS 0
+#endif
+
+#if JUCE_MSVC
+ #define PLUCK_TARGET(isa)
+#else
+ #define PLUCK_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+// Structure-of-arrays state of one group of voices, gathered by VoiceBank for a kernel call
+struct VoiceLanes
+{
+    static constexpr int maxLanes = 16;
+
+    alignas(64) float h0[maxLanes], h1[maxLanes], h2[maxLanes], h3[maxLanes];
+    alignas(64) float g[maxLanes], state[maxLanes];
+    alignas(64) float b0[maxLanes], b1[maxLanes], b2[maxLanes], a1[maxLanes], a2[maxLanes];
+    alignas(64) float z1[maxLanes], z2[maxLanes];
+    alignas(64) float decay[maxLanes], gain[maxLanes], gainStep[maxLanes], energy[maxLanes];
+    alignas(64) float roundingError[maxLanes]; // half float lines only
+
+    float* delayData[maxLanes];
+    juce::uint16* halfData[maxLanes];
+    const float* excitation[maxLanes];
+    int mask[maxLanes], readPosition[maxLanes], writePosition[maxLanes];
+    int excitationPosition[maxLanes], excitationLength[maxLanes];
+};
+
+// Hot inner loops built for several instruction sets. The widest one the CPU supports is
+// picked once in prepareToPlay; on other architectures only the baseline set exists.
+struct DspKernels
+{
+    enum Isa
+    {
+        baseline = 0,
+        avx2,
+        avx512,
+        numIsas
+    };
+
+    const char* name;
+    int lanes;
+
+    // Runs lanes string loops, adds their sum to out and leaves each lane's mean square in energy
+    void (*renderVoices)(VoiceLanes& voices, float* out, int numSamples);
+
+    // The same loops on half float lines, with noise-shaped rounding as in HalfFloat::fromFloatShaped
+    void (*renderHalfVoices)(VoiceLanes& voices, float* out, int numSamples);
+
+    // samples[i] *= gain[i]
+    void (*multiply)(float* samples, const float* gain, int numSamples);
+
+    // Compiled into this build and supported by this CPU
+    static bool isAvailable(int isa);
+    static int detectIsa();
+
+    // Falls back to the baseline set for anything unavailable
+    static const DspKernels& get(int isa);
+};
+
+namespace KernelVariants
+{
+    extern const DspKernels baselineKernels;
+   #if PLUCK_X86_KERNELS
+    extern const DspKernels avx2Kernels;
+    extern const DspKernels avx512Kernels;
+   #endif
+}
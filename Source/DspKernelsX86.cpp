@@ -0,0 +1,258 @@
+#include "DspKernels.h"
+#include "HalfFloat.h"
+
+#if PLUCK_X86_KERNELS
+#include <immintrin.h>
+
+// Same loop as the baseline kernel, eight or sixteen voices to a register and the filter taps fused.
+// Results differ from the baseline only by fused multiply-add rounding. Half float lines are converted
+// a register at a time with F16C, which every AVX2 and AVX-512 CPU has.
+namespace
+{
+    // Delay taps and exciters are per lane
+    template <int lanes>
+    inline void gatherTaps(VoiceLanes& v, float* excitation, float* x0, float* x1, float* x2, float* x3)
+    {
+        for (int lane = 0; lane < lanes; ++lane)
+        {
+            const int read = v.readPosition[lane];
+            const int m = v.mask[lane];
+            const float* data = v.delayData[lane];
+
+            x0[lane] = data[read];
+            x1[lane] = data[(read - 1) & m];
+            x2[lane] = data[(read - 2) & m];
+            x3[lane] = data[(read - 3) & m];
+            excitation[lane] = v.excitationPosition[lane] < v.excitationLength[lane] ? v.excitation[lane][v.excitationPosition[lane]++] : 0.0f;
+        }
+    }
+
+    template <int lanes>
+    inline void gatherHalfTaps(VoiceLanes& v, float* excitation, juce::uint16* x0, juce::uint16* x1, juce::uint16* x2, juce::uint16* x3)
+    {
+        for (int lane = 0; lane < lanes; ++lane)
+        {
+            const int read = v.readPosition[lane];
+            const int m = v.mask[lane];
+            const juce::uint16* data = v.halfData[lane];
+
+            x0[lane] = data[read];
+            x1[lane] = data[(read - 1) & m];
+            x2[lane] = data[(read - 2) & m];
+            x3[lane] = data[(read - 3) & m];
+            excitation[lane] = v.excitationPosition[lane] < v.excitationLength[lane] ? v.excitation[lane][v.excitationPosition[lane]++] : 0.0f;
+        }
+    }
+
+    template <int lanes, typename Sample>
+    inline void advance(VoiceLanes& v, const Sample* written)
+    {
+        for (int lane = 0; lane < lanes; ++lane)
+        {
+            if constexpr (std::is_same_v<Sample, juce::uint16>)
+                v.halfData[lane][v.writePosition[lane]] = written[lane];
+            else
+                v.delayData[lane][v.writePosition[lane]] = written[lane];
+
+            v.readPosition[lane] = (v.readPosition[lane] + 1) & v.mask[lane];
+            v.writePosition[lane] = (v.writePosition[lane] + 1) & v.mask[lane];
+        }
+    }
+
+    //==============================================================================
+    PLUCK_TARGET("avx2,fma") inline float sum256(__m256 x)
+    {
+        const __m128 pairs = _mm_add_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+        const __m128 halves = _mm_add_ps(pairs, _mm_movehl_ps(pairs, pairs));
+        return _mm_cvtss_f32(_mm_add_ss(halves, _mm_shuffle_ps(halves, halves, 1)));
+    }
+
+    template <bool halfLines>
+    PLUCK_TARGET("avx2,fma,f16c") void renderVoicesAvx2(VoiceLanes& v, float* out, int numSamples)
+    {
+        constexpr int lanes = 8;
+        alignas(32) float x0[lanes], x1[lanes], x2[lanes], x3[lanes], excitation[lanes], written[lanes];
+        alignas(16) juce::uint16 r0[lanes], r1[lanes], r2[lanes], r3[lanes], halfWritten[lanes];
+
+        const __m256 H0 = _mm256_load_ps(v.h0), H1 = _mm256_load_ps(v.h1), H2 = _mm256_load_ps(v.h2), H3 = _mm256_load_ps(v.h3);
+        const __m256 G = _mm256_load_ps(v.g);
+        const __m256 B0 = _mm256_load_ps(v.b0), B1 = _mm256_load_ps(v.b1), B2 = _mm256_load_ps(v.b2);
+        const __m256 A1 = _mm256_load_ps(v.a1), A2 = _mm256_load_ps(v.a2);
+        const __m256 Decay = _mm256_load_ps(v.decay), GainStep = _mm256_load_ps(v.gainStep);
+        const __m256 Zero = _mm256_setzero_ps();
+        __m256 State = _mm256_load_ps(v.state), Z1 = _mm256_load_ps(v.z1), Z2 = _mm256_load_ps(v.z2);
+        __m256 Gain = _mm256_load_ps(v.gain), Energy = Zero;
+        __m256 RoundingError = _mm256_load_ps(v.roundingError);
+        const __m256 MaxValue = _mm256_set1_ps(HalfFloat::maxValue), MinValue = _mm256_set1_ps(-HalfFloat::maxValue);
+
+        for (int sample = 0; sample < numSamples; ++sample)
+        {
+            __m256 X0, X1, X2, X3;
+
+            if constexpr (halfLines)
+            {
+                gatherHalfTaps<lanes>(v, excitation, r0, r1, r2, r3);
+                X0 = _mm256_cvtph_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(r0)));
+                X1 = _mm256_cvtph_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(r1)));
+                X2 = _mm256_cvtph_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(r2)));
+                X3 = _mm256_cvtph_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(r3)));
+            }
+            else
+            {
+                gatherTaps<lanes>(v, excitation, x0, x1, x2, x3);
+                X0 = _mm256_load_ps(x0);
+                X1 = _mm256_load_ps(x1);
+                X2 = _mm256_load_ps(x2);
+                X3 = _mm256_load_ps(x3);
+            }
+
+            __m256 X = _mm256_mul_ps(H0, X0);
+            X = _mm256_fmadd_ps(H1, X1, X);
+            X = _mm256_fmadd_ps(H2, X2, X);
+            X = _mm256_fmadd_ps(H3, X3, X);
+            X = _mm256_fnmadd_ps(G, State, X);
+            State = X;
+
+            const __m256 Y = _mm256_fmadd_ps(B0, X, Z1);
+            Z1 = _mm256_fnmadd_ps(A1, Y, _mm256_fmadd_ps(B1, X, Z2));
+            Z2 = _mm256_fnmadd_ps(A2, Y, _mm256_mul_ps(B2, X));
+
+            const __m256 Written = _mm256_fmadd_ps(Y, Decay, _mm256_load_ps(excitation));
+
+            if constexpr (halfLines)
+            {
+                // Noise-shaped rounding, as HalfFloat::fromFloatShaped
+                const __m256 Shaped = _mm256_min_ps(MaxValue, _mm256_max_ps(MinValue, _mm256_add_ps(Written, RoundingError)));
+                const __m128i Half = _mm256_cvtps_ph(Shaped, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+                RoundingError = _mm256_sub_ps(Shaped, _mm256_cvtph_ps(Half));
+                _mm_store_si128(reinterpret_cast<__m128i*>(halfWritten), Half);
+                advance<lanes>(v, halfWritten);
+            }
+            else
+            {
+                _mm256_store_ps(written, Written);
+                advance<lanes>(v, written);
+            }
+
+            const __m256 Output = _mm256_mul_ps(Y, Gain);
+            Gain = _mm256_max_ps(Zero, _mm256_add_ps(Gain, GainStep));
+            Energy = _mm256_fmadd_ps(Output, Output, Energy);
+            out[sample] += sum256(Output);
+        }
+
+        _mm256_store_ps(v.state, State);
+        _mm256_store_ps(v.z1, Z1);
+        _mm256_store_ps(v.z2, Z2);
+        _mm256_store_ps(v.gain, Gain);
+        _mm256_store_ps(v.roundingError, RoundingError);
+        _mm256_store_ps(v.energy, _mm256_mul_ps(Energy, _mm256_set1_ps(1.0f / static_cast<float>(juce::jmax(1, numSamples)))));
+    }
+
+    PLUCK_TARGET("avx2,fma") void multiplyAvx2(float* samples, const float* gain, int numSamples)
+    {
+        int i = 0;
+        for (; i + 8 <= numSamples; i += 8)
+            _mm256_storeu_ps(samples + i, _mm256_mul_ps(_mm256_loadu_ps(samples + i), _mm256_loadu_ps(gain + i)));
+
+        for (; i < numSamples; ++i)
+            samples[i] *= gain[i];
+    }
+
+    //==============================================================================
+    template <bool halfLines>
+    PLUCK_TARGET("avx512f") void renderVoicesAvx512(VoiceLanes& v, float* out, int numSamples)
+    {
+        constexpr int lanes = 16;
+        alignas(64) float x0[lanes], x1[lanes], x2[lanes], x3[lanes], excitation[lanes], written[lanes];
+        alignas(32) juce::uint16 r0[lanes], r1[lanes], r2[lanes], r3[lanes], halfWritten[lanes];
+
+        const __m512 H0 = _mm512_load_ps(v.h0), H1 = _mm512_load_ps(v.h1), H2 = _mm512_load_ps(v.h2), H3 = _mm512_load_ps(v.h3);
+        const __m512 G = _mm512_load_ps(v.g);
+        const __m512 B0 = _mm512_load_ps(v.b0), B1 = _mm512_load_ps(v.b1), B2 = _mm512_load_ps(v.b2);
+        const __m512 A1 = _mm512_load_ps(v.a1), A2 = _mm512_load_ps(v.a2);
+        const __m512 Decay = _mm512_load_ps(v.decay), GainStep = _mm512_load_ps(v.gainStep);
+        const __m512 Zero = _mm512_setzero_ps();
+        __m512 State = _mm512_load_ps(v.state), Z1 = _mm512_load_ps(v.z1), Z2 = _mm512_load_ps(v.z2);
+        __m512 Gain = _mm512_load_ps(v.gain), Energy = Zero;
+        __m512 RoundingError = _mm512_load_ps(v.roundingError);
+        const __m512 MaxValue = _mm512_set1_ps(HalfFloat::maxValue), MinValue = _mm512_set1_ps(-HalfFloat::maxValue);
+
+        for (int sample = 0; sample < numSamples; ++sample)
+        {
+            __m512 X0, X1, X2, X3;
+
+            if constexpr (halfLines)
+            {
+                gatherHalfTaps<lanes>(v, excitation, r0, r1, r2, r3);
+                X0 = _mm512_cvtph_ps(_mm256_load_si256(reinterpret_cast<const __m256i*>(r0)));
+                X1 = _mm512_cvtph_ps(_mm256_load_si256(reinterpret_cast<const __m256i*>(r1)));
+                X2 = _mm512_cvtph_ps(_mm256_load_si256(reinterpret_cast<const __m256i*>(r2)));
+                X3 = _mm512_cvtph_ps(_mm256_load_si256(reinterpret_cast<const __m256i*>(r3)));
+            }
+            else
+            {
+                gatherTaps<lanes>(v, excitation, x0, x1, x2, x3);
+                X0 = _mm512_load_ps(x0);
+                X1 = _mm512_load_ps(x1);
+                X2 = _mm512_load_ps(x2);
+                X3 = _mm512_load_ps(x3);
+            }
+
+            __m512 X = _mm512_mul_ps(H0, X0);
+            X = _mm512_fmadd_ps(H1, X1, X);
+            X = _mm512_fmadd_ps(H2, X2, X);
+            X = _mm512_fmadd_ps(H3, X3, X);
+            X = _mm512_fnmadd_ps(G, State, X);
+            State = X;
+
+            const __m512 Y = _mm512_fmadd_ps(B0, X, Z1);
+            Z1 = _mm512_fnmadd_ps(A1, Y, _mm512_fmadd_ps(B1, X, Z2));
+            Z2 = _mm512_fnmadd_ps(A2, Y, _mm512_mul_ps(B2, X));
+
+            const __m512 Written = _mm512_fmadd_ps(Y, Decay, _mm512_load_ps(excitation));
+
+            if constexpr (halfLines)
+            {
+                const __m512 Shaped = _mm512_min_ps(MaxValue, _mm512_max_ps(MinValue, _mm512_add_ps(Written, RoundingError)));
+                const __m256i Half = _mm512_cvtps_ph(Shaped, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+                RoundingError = _mm512_sub_ps(Shaped, _mm512_cvtph_ps(Half));
+                _mm256_store_si256(reinterpret_cast<__m256i*>(halfWritten), Half);
+                advance<lanes>(v, halfWritten);
+            }
+            else
+            {
+                _mm512_store_ps(written, Written);
+                advance<lanes>(v, written);
+            }
+
+            const __m512 Output = _mm512_mul_ps(Y, Gain);
+            Gain = _mm512_max_ps(Zero, _mm512_add_ps(Gain, GainStep));
+            Energy = _mm512_fmadd_ps(Output, Output, Energy);
+            out[sample] += _mm512_reduce_add_ps(Output);
+        }
+
+        _mm512_store_ps(v.state, State);
+        _mm512_store_ps(v.z1, Z1);
+        _mm512_store_ps(v.z2, Z2);
+        _mm512_store_ps(v.gain, Gain);
+        _mm512_store_ps(v.roundingError, RoundingError);
+        _mm512_store_ps(v.energy, _mm512_mul_ps(Energy, _mm512_set1_ps(1.0f / static_cast<float>(juce::jmax(1, numSamples)))));
+    }
+
+    PLUCK_TARGET("avx512f") void multiplyAvx512(float* samples, const float* gain, int numSamples)
+    {
+        int i = 0;
+        for (; i + 16 <= numSamples; i += 16)
+            _mm512_storeu_ps(samples + i, _mm512_mul_ps(_mm512_loadu_ps(samples + i), _mm512_loadu_ps(gain + i)));
+
+        for (; i < numSamples; ++i)
+            samples[i] *= gain[i];
+    }
+}
+
+namespace KernelVariants
+{
+    const DspKernels avx2Kernels { "avx2", 8, renderVoicesAvx2<false>, renderVoicesAvx2<true>, multiplyAvx2 };
+    const DspKernels avx512Kernels { "avx512", 16, renderVoicesAvx512<false>, renderVoicesAvx512<true>, multiplyAvx512 };
+}
+#endif
@@ -0,0 +1,164 @@
+#include "ExciterBank.h"
+
+ExciterBank::Tables::Tables()
+{
+    // One extra point so the interpolation never wraps
+    for (int i = 0; i <= tableSize; ++i)
+        sine[i] = std::sin(juce::MathConstants<float>::twoPi * static_cast<float>(i) / static_cast<float>(tableSize));
+
+    // Blackman-windowed sinc, passband to 90% of the output Nyquist, unity gain at DC
+    const double cutoff = 0.45 / oversamplingFactor;
+    const int centre = decimatorLength / 2;
+    double sum = 0.0;
+
+    for (int i = 0; i < decimatorLength; ++i)
+    {
+        const double x = static_cast<double>(i - centre);
+        const double sinc = i == centre ? 2.0 * cutoff : std::sin(juce::MathConstants<double>::twoPi * cutoff * x) / (juce::MathConstants<double>::pi * x);
+        const double w = juce::MathConstants<double>::twoPi * i / (decimatorLength - 1);
+        const double window = 0.42 - 0.5 * std::cos(w) + 0.08 * std::cos(2.0 * w);
+        decimator[i] = static_cast<float>(sinc * window);
+        sum += sinc * window;
+    }
+
+    for (auto& tap : decimator)
+        tap = static_cast<float>(tap / sum);
+}
+
+int ExciterBank::getMaxBurstLength(double sampleRate)
+{
+    return static_cast<int>(std::ceil(maxBurstSeconds * sampleRate)) + 1;
+}
+
+float ExciterBank::polyBlep(float phase, float phaseIncrement)
+{
+    // Polynomial correction around a unit step at phase 0
+    if (phase < phaseIncrement)
+    {
+        const float x = phase / phaseIncrement;
+        return x + x - x * x - 1.0f;
+    }
+
+    if (phase > 1.0f - phaseIncrement)
+    {
+        const float x = (phase - 1.0f) / phaseIncrement;
+        return x * x + x + x + 1.0f;
+    }
+
+    return 0.0f;
+}
+
+float ExciterBank::sawtoothSample(float phase, float phaseIncrement)
+{
+    return 2.0f * phase - 1.0f - polyBlep(phase, phaseIncrement);
+}
+
+float ExciterBank::squareSample(float phase, float phaseIncrement)
+{
+    float halfPhase = phase + 0.5f;
+    if (halfPhase >= 1.0f) halfPhase -= 1.0f;
+
+    return (phase < 0.5f ? 1.0f : -1.0f) + polyBlep(phase, phaseIncrement) - polyBlep(halfPhase, phaseIncrement);
+}
+
+float ExciterBank::lookupSine(float phase) const
+{
+    const float position = phase * static_cast<float>(tableSize);
+    const int index = static_cast<int>(position);
+    const float fraction = position - static_cast<float>(index);
+    return tables->sine[index] + fraction * (tables->sine[index + 1] - tables->sine[index]);
+}
+
+int ExciterBank::render(float* burst, int maxLength, int source, float frequency, float width, double sampleRate, juce::uint32& noiseSeed) const
+{
+    const int length = juce::jlimit(0, maxLength, static_cast<int>(std::ceil(width * sampleRate)));
+    const float phaseIncrement = frequency / static_cast<float>(sampleRate);
+    float phase = 0.0f;
+
+    if (oversample && (source == sawtooth || source == square))
+    {
+        renderOversampled(burst, length, source, phaseIncrement / static_cast<float>(oversamplingFactor));
+        return length;
+    }
+
+    switch (source)
+    {
+        case sine:
+            for (int i = 0; i < length; ++i)
+            {
+                burst[i] = lookupSine(phase);
+                phase += phaseIncrement;
+                if (phase >= 1.0f) phase -= 1.0f;
+            }
+            break;
+
+        case sawtooth:
+            for (int i = 0; i < length; ++i)
+            {
+                burst[i] = sawtoothSample(phase, phaseIncrement);
+                phase += phaseIncrement;
+                if (phase >= 1.0f) phase -= 1.0f;
+            }
+            break;
+
+        case square:
+            for (int i = 0; i < length; ++i)
+            {
+                burst[i] = squareSample(phase, phaseIncrement);
+                phase += phaseIncrement;
+                if (phase >= 1.0f) phase -= 1.0f;
+            }
+            break;
+
+        case noise:
+        default:
+            for (int i = 0; i < length; ++i)
+            {
+                // xorshift32
+                noiseSeed ^= noiseSeed << 13;
+                noiseSeed ^= noiseSeed >> 17;
+                noiseSeed ^= noiseSeed << 5;
+                burst[i] = static_cast<float>(static_cast<juce::int32>(noiseSeed)) * (1.0f / 2147483648.0f);
+            }
+            break;
+    }
+
+    return length;
+}
+
+void ExciterBank::renderOversampled(float* burst, int length, int source, float phaseIncrement) const
+{
+    // Sub-samples go into a doubled ring, so the decimator always reads one contiguous stretch
+    float ring[2 * decimatorLength] = {};
+    int ringPosition = 0;
+    float phase = 0.0f;
+
+    const int numSubSamples = length * oversamplingFactor;
+    const int centre = decimatorLength / 2;
+
+    for (int sub = 0, out = 0; out < length; ++sub)
+    {
+        float x = 0.0f;
+
+        // The burst stops dead after its length, like the plain one
+        if (sub < numSubSamples)
+        {
+            x = source == sawtooth ? sawtoothSample(phase, phaseIncrement) : squareSample(phase, phaseIncrement);
+            phase += phaseIncrement;
+            if (phase >= 1.0f) phase -= 1.0f;
+        }
+
+        ring[ringPosition] = ring[ringPosition + decimatorLength] = x;
+        ringPosition = ringPosition + 1 == decimatorLength ? 0 : ringPosition + 1;
+
+        // Output sample out sits at sub-sample out * factor, in the middle of the filter
+        if (sub >= centre && (sub - centre) % oversamplingFactor == 0)
+        {
+            float sum = 0.0f;
+            for (int tap = 0; tap < decimatorLength; ++tap)
+                sum += tables->decimator[tap] * ring[ringPosition + tap];
+
+            burst[out++] = sum;
+        }
+    }
+}
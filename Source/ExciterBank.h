@@ -0,0 +1,53 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Renders the excitation burst for a note in one go at note start, so the string loop only reads samples.
+// Sine comes from a wavetable, sawtooth and square are band-limited with polyBLEP,
+// noise uses a per-voice xorshift generator instead of the shared juce::Random.
+// When oversampling, sawtooth and square are rendered at four times the rate and decimated.
+class ExciterBank
+{
+public:
+    enum Source
+    {
+        sine = 0,
+        sawtooth,
+        square,
+        noise,
+        numSources
+    };
+
+    // Longest burst the width parameter can ask for
+    static constexpr float maxBurstSeconds = 0.02f;
+
+    static int getMaxBurstLength(double sampleRate);
+
+    // Set by the quality tier, only read on the thread that starts notes
+    void setOversampling(bool shouldOversample)  { oversample = shouldOversample; }
+
+    // Writes the burst into the buffer and returns its length
+    int render(float* burst, int maxLength, int source, float frequency, float width, double sampleRate, juce::uint32& noiseSeed) const;
+
+private:
+    static float polyBlep(float phase, float phaseIncrement);
+    static float sawtoothSample(float phase, float phaseIncrement);
+    static float squareSample(float phase, float phaseIncrement);
+    float lookupSine(float phase) const;
+    void renderOversampled(float* burst, int length, int source, float phaseIncrement) const;
+
+    static constexpr int tableSize = 2048;
+    static constexpr int oversamplingFactor = 4;
+    static constexpr int decimatorLength = 16 * oversamplingFactor + 1; // odd, centred on an output sample
+
+    // Built once per process and shared by every bank
+    struct Tables
+    {
+        Tables();
+
+        float sine[tableSize + 1];
+        float decimator[decimatorLength];
+    };
+
+    juce::SharedResourcePointer<Tables> tables;
+    bool oversample = false;
+};
@@ -0,0 +1,258 @@
+#include "FdnReverb.h"
+
+namespace
+{
+    // Mutually prime-ish line lengths in milliseconds
+    constexpr float lineMilliseconds[FdnReverb::numLines] = { 29.7f, 37.1f, 41.1f, 43.7f, 53.3f, 59.9f, 67.1f, 73.3f };
+
+    // Input spread and two orthogonal output taps for left and right
+    alignas(FdnReverb::Register::SIMDRegisterSize) constexpr float inputGains[FdnReverb::numLines] = { 0.35f, -0.35f, 0.35f, -0.35f, 0.35f, -0.35f, 0.35f, -0.35f };
+    alignas(FdnReverb::Register::SIMDRegisterSize) constexpr float leftGains[FdnReverb::numLines]  = { 0.25f, 0.25f, -0.25f, -0.25f, 0.25f, 0.25f, -0.25f, -0.25f };
+    alignas(FdnReverb::Register::SIMDRegisterSize) constexpr float rightGains[FdnReverb::numLines] = { 0.25f, -0.25f, 0.25f, -0.25f, -0.25f, 0.25f, -0.25f, 0.25f };
+
+    constexpr float dampingFrequency = 6000.0f;
+}
+
+void FdnReverb::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+
+    longestLine = 0;
+    for (int line = 0; line < numLines; ++line)
+    {
+        lengths[line] = juce::roundToInt(lineMilliseconds[line] * 0.001 * sampleRate) | 1;
+        longestLine = juce::jmax(longestLine, lengths[line]);
+    }
+
+    lineSize = juce::nextPowerOfTwo(longestLine + 1);
+    mask = lineSize - 1;
+
+    // One extra frame to align the first one
+    memory.calloc(static_cast<size_t>((lineSize + 1) * numLines));
+    lines = juce::snapPointerToAlignment(memory.get(), Register::SIMDRegisterSize);
+
+    damping = std::exp(-juce::MathConstants<float>::twoPi * dampingFrequency / static_cast<float>(sampleRate));
+    size = -1.0f;
+    reset();
+}
+
+void FdnReverb::reset()
+{
+    juce::FloatVectorOperations::clear(lines, lineSize * numLines);
+    juce::FloatVectorOperations::clear(dampingState, numLines);
+    writePosition = 0;
+    quietSamples = 0;
+    asleep = true;
+}
+
+void FdnReverb::setEconomy(bool shouldUseEconomy)
+{
+    if (shouldUseEconomy == economy)
+        return;
+
+    // Lines that sat out still hold the tail from before, which would come back as an echo
+    if (economy)
+    {
+        for (int frame = 0; frame < lineSize; ++frame)
+            for (int line = 1; line < numLines; line += 2)
+                lines[frame * numLines + line] = 0.0f;
+
+        for (int line = 1; line < numLines; line += 2)
+            dampingState[line] = 0.0f;
+    }
+
+    economy = shouldUseEconomy;
+}
+
+void FdnReverb::setSize(float newSize)
+{
+    if (newSize == size)
+        return;
+
+    size = newSize;
+
+    // Each line loses 60 dB over the decay time, scaled by its own length
+    const float decaySeconds = getDecaySeconds(size);
+    for (int line = 0; line < numLines; ++line)
+        decayGains[line] = std::pow(0.001f, static_cast<float>(lengths[line]) / (decaySeconds * static_cast<float>(sampleRate)));
+}
+
+float FdnReverb::getDecaySeconds(float size)
+{
+    return 0.2f + 7.8f * size * size;
+}
+
+float FdnReverb::getTailSeconds(float size)
+{
+    // -120 dB is twice the -60 dB decay time, plus one pass through the longest line
+    return 2.0f * getDecaySeconds(size) + lineMilliseconds[numLines - 1] * 0.001f;
+}
+
+void FdnReverb::process(const float* in, float* left, float* right, const float* wetMix, const float* gain, int numSamples)
+{
+    const auto inputRange = juce::FloatVectorOperations::findMinAndMax(in, numSamples);
+    const float inputPeak = juce::jmax(-inputRange.getStart(), inputRange.getEnd());
+
+    // Nothing in and nothing left ringing, only the dry signal is written
+    if (asleep && inputPeak < sleepThreshold)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float dry = in[i] * gain[i] * (1.0f - wetMix[i]);
+            left[i] = dry;
+            if (right != nullptr)
+                right[i] = dry;
+        }
+        return;
+    }
+
+    asleep = false;
+
+    if (economy)
+    {
+        if (right != nullptr)
+            processLines<2, 2>(in, left, right, wetMix, gain, numSamples);
+        else
+            processLines<1, 2>(in, left, right, wetMix, gain, numSamples);
+    }
+    else
+    {
+        if (right != nullptr)
+            processLines<2, 1>(in, left, right, wetMix, gain, numSamples);
+        else
+            processLines<1, 1>(in, left, right, wetMix, gain, numSamples);
+    }
+
+    // Go to sleep once everything in the lines has been read back below the threshold
+    if (inputPeak < sleepThreshold && linePeak < sleepThreshold)
+        quietSamples += numSamples;
+    else
+        quietSamples = 0;
+
+    if (quietSamples > longestLine)
+        reset();
+}
+
+template <int numChannels, int stride>
+void FdnReverb::processLines(const float* in, float* left, float* right, const float* wetMix, const float* gain, int numSamples)
+{
+    // Lines 0, stride, 2 * stride... run, with the input spread over fewer of them at a higher gain.
+    // Whole registers first, then the lines left over one at a time.
+    constexpr int activeLines = numLines / stride;
+    constexpr int activeRegisters = activeLines / lanes;
+    constexpr int registerLines = activeRegisters * lanes;
+    constexpr int registerSlots = activeRegisters > 0 ? activeRegisters : 1;
+    const float scale = std::sqrt(static_cast<float>(stride));
+
+    alignas(Register::SIMDRegisterSize) float decay[activeLines], input[activeLines], leftOut[activeLines], rightOut[activeLines], state[activeLines];
+
+    for (int k = 0; k < activeLines; ++k)
+    {
+        decay[k] = decayGains[k * stride];
+        input[k] = inputGains[k * stride] * scale;
+        leftOut[k] = leftGains[k * stride];
+        rightOut[k] = rightGains[k * stride];
+        state[k] = dampingState[k * stride];
+    }
+
+    Register Decay[registerSlots], InputGain[registerSlots], LeftGain[registerSlots], RightGain[registerSlots], State[registerSlots];
+
+    for (int r = 0; r < activeRegisters; ++r)
+    {
+        Decay[r] = Register::fromRawArray(decay + r * lanes);
+        InputGain[r] = Register::fromRawArray(input + r * lanes);
+        LeftGain[r] = Register::fromRawArray(leftOut + r * lanes);
+        RightGain[r] = Register::fromRawArray(rightOut + r * lanes);
+        State[r] = Register::fromRawArray(state + r * lanes);
+    }
+
+    const auto Damping = Register::expand(damping);
+    const float householder = -2.0f / static_cast<float>(activeLines);
+
+    auto Peak = Register::expand(0.0f);
+    float peak = 0.0f;
+    alignas(Register::SIMDRegisterSize) float taps[activeLines];
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        // Read every line at its own length
+        for (int k = 0; k < activeLines; ++k)
+            taps[k] = lines[((writePosition - lengths[k * stride]) & mask) * numLines + k * stride];
+
+        // Damping low-pass, then the output taps
+        auto Left = Register::expand(0.0f), Right = Register::expand(0.0f);
+        float leftSum = 0.0f, rightSum = 0.0f, sum = 0.0f;
+
+        for (int r = 0; r < activeRegisters; ++r)
+        {
+            const auto X = Register::fromRawArray(taps + r * lanes);
+            State[r] = X + (State[r] - X) * Damping;
+            Peak = Register::max(Peak, Register::abs(State[r]));
+            Left += State[r] * LeftGain[r];
+            if constexpr (numChannels == 2)
+                Right += State[r] * RightGain[r];
+            sum += State[r].sum();
+        }
+
+        for (int k = registerLines; k < activeLines; ++k)
+        {
+            state[k] = taps[k] + (state[k] - taps[k]) * damping;
+            peak = juce::jmax(peak, std::abs(state[k]));
+            leftSum += state[k] * leftOut[k];
+            if constexpr (numChannels == 2)
+                rightSum += state[k] * rightOut[k];
+            sum += state[k];
+        }
+
+        // Householder reflection, decay and input, written as one interleaved frame
+        const float reflection = householder * sum;
+        const auto Reflection = Register::expand(reflection);
+        const auto Input = Register::expand(in[i]);
+        float* frame = lines + writePosition * numLines;
+
+        for (int k = registerLines; k < activeLines; ++k)
+            frame[k * stride] = (state[k] + reflection) * decay[k] + in[i] * input[k];
+
+        if constexpr (stride == 1)
+        {
+            for (int r = 0; r < activeRegisters; ++r)
+                ((State[r] + Reflection) * Decay[r] + Input * InputGain[r]).copyToRawArray(frame + r * lanes);
+        }
+        else
+        {
+            alignas(Register::SIMDRegisterSize) float written[activeLines];
+
+            for (int r = 0; r < activeRegisters; ++r)
+                ((State[r] + Reflection) * Decay[r] + Input * InputGain[r]).copyToRawArray(written + r * lanes);
+
+            for (int k = 0; k < registerLines; ++k)
+                frame[k * stride] = written[k];
+        }
+
+        writePosition = (writePosition + 1) & mask;
+
+        // Fused dry/wet and output gain
+        const float wet = gain[i] * wetMix[i];
+        const float dry = in[i] * (gain[i] - wet);
+
+        if constexpr (numChannels == 2)
+        {
+            left[i] = dry + (Left.sum() + leftSum) * wet;
+            right[i] = dry + (Right.sum() + rightSum) * wet;
+        }
+        else
+        {
+            left[i] = dry + (Left.sum() + leftSum) * wet;
+        }
+    }
+
+    for (int r = 0; r < activeRegisters; ++r)
+        State[r].copyToRawArray(state + r * lanes);
+
+    for (int k = 0; k < activeLines; ++k)
+        dampingState[k * stride] = state[k];
+
+    alignas(Register::SIMDRegisterSize) float peaks[lanes];
+    Peak.copyToRawArray(peaks);
+    linePeak = juce::jmax(peak, juce::findMaximum(peaks, lanes));
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <JuceHeader.h>
+#include <juce_dsp/juce_dsp.h>
+
+// Eight-line feedback delay network with a Householder feedback matrix.
+// The lines are stored interleaved and processed side by side in SIMD registers, with any lines that don't fill
+// a whole register (the economy lines on 8-lane AVX) done one at a time.
+// Dry/wet/gain are applied as the output is written, so the block is touched once.
+// In economy mode only every other line runs, for half the cost and a sparser tail.
+class FdnReverb
+{
+public:
+    using Register = juce::dsp::SIMDRegister<float>;
+    static constexpr int numLines = 8;
+    static constexpr int lanes = static_cast<int>(Register::SIMDNumElements);
+
+    // Input and tail level below which processing stops, -120 dB
+    static constexpr float sleepThreshold = 1.0e-6f;
+
+    void prepare(double sampleRate);
+    void reset();
+
+    // 0..1, mapped to the decay time
+    void setSize(float newSize);
+
+    // Runs every other line. The idle lines are cleared when they are brought back.
+    void setEconomy(bool shouldUseEconomy);
+    static float getDecaySeconds(float size);
+
+    // Time for the tail to fall below the sleep threshold once the input stops
+    static float getTailSeconds(float size);
+
+    // out = in * gain * (1 - mix) + wet * gain * mix, per sample. right may be null for a mono output.
+    void process(const float* in, float* left, float* right, const float* wetMix, const float* gain, int numSamples);
+
+    bool isAsleep() const    { return asleep; }
+
+private:
+    template <int numChannels, int stride>
+    void processLines(const float* in, float* left, float* right, const float* wetMix, const float* gain, int numSamples);
+
+    juce::HeapBlock<float> memory;
+    float* lines = nullptr;       // lineSize frames of numLines interleaved samples
+    int lineSize = 0, mask = 0, writePosition = 0;
+    int lengths[numLines] = {};
+    int longestLine = 0;
+    int quietSamples = 0;   // consecutive samples with input and line outputs below the threshold
+    float linePeak = 0.0f;  // largest line output of the last block
+
+    alignas(Register::SIMDRegisterSize) float decayGains[numLines] = {};
+    alignas(Register::SIMDRegisterSize) float dampingState[numLines] = {};
+
+    double sampleRate = 44100.0;
+    float size = -1.0f;
+    float damping = 0.0f;
+    bool asleep = true;
+    bool economy = false;
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include <JuceHeader.h>
+
+// IEEE 754 half floats for compact string loops, see DelayLinePool::half.
+// These are the portable scalar conversions, bit-exact with the F16C instructions the x86 kernels use:
+// round to nearest even, subnormals kept. Values beyond the half range saturate instead of turning infinite.
+namespace HalfFloat
+{
+    constexpr float maxValue = 65504.0f;
+
+    inline float toFloat(juce::uint16 half)
+    {
+        constexpr juce::uint32 exponentMask = 0x7c00u << 13;
+        juce::uint32 bits = (static_cast<juce::uint32>(half) & 0x7fffu) << 13;
+        const juce::uint32 exponent = bits & exponentMask;
+        bits += (127u - 15u) << 23;
+
+        if (exponent == exponentMask)
+        {
+            bits += (128u - 16u) << 23;
+        }
+        else if (exponent == 0)
+        {
+            // Subnormal: let the float unit normalise it
+            bits += 1u << 23;
+            float value;
+            std::memcpy(&value, &bits, sizeof(float));
+            value -= 6.103515625e-05f; // 2^-14
+            std::memcpy(&bits, &value, sizeof(float));
+        }
+
+        bits |= (static_cast<juce::uint32>(half) & 0x8000u) << 16;
+        float value;
+        std::memcpy(&value, &bits, sizeof(float));
+        return value;
+    }
+
+    inline juce::uint16 fromFloat(float value)
+    {
+        juce::uint32 bits;
+        std::memcpy(&bits, &value, sizeof(float));
+        const auto sign = static_cast<juce::uint16>((bits >> 16) & 0x8000u);
+        bits &= 0x7fffffffu;
+
+        // 65520 and up would round to infinity, NaN included
+        if (bits >= 0x477ff000u)
+            return static_cast<juce::uint16>(sign | 0x7bffu);
+
+        if (bits < (113u << 23))
+        {
+            // Below the smallest normal half: adding 0.5 lines the half's subnormal bits up with the float mantissa
+            constexpr juce::uint32 magicBits = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+            float magic, magnitude;
+            std::memcpy(&magic, &magicBits, sizeof(float));
+            std::memcpy(&magnitude, &bits, sizeof(float));
+            magnitude += magic;
+            std::memcpy(&bits, &magnitude, sizeof(float));
+            return static_cast<juce::uint16>(sign | (bits - magicBits));
+        }
+
+        // Rebias the exponent and round the 13 dropped mantissa bits to nearest even
+        const juce::uint32 odd = (bits >> 13) & 1u;
+        bits += ((15u - 127u) << 23) + 0xfffu + odd;
+        return static_cast<juce::uint16>(sign | (bits >> 13));
+    }
+
+    // First-order noise shaping: the rounding error of each sample is added to the next one, which pushes the
+    // error towards high frequencies where the string's loop filter removes it, and keeps slowly decaying tails
+    // from sticking at a rounded value
+    inline juce::uint16 fromFloatShaped(float value, float& error)
+    {
+        const float shaped = juce::jlimit(-maxValue, maxValue, value + error);
+        const auto half = fromFloat(shaped);
+        error = shaped - toFloat(half);
+        return half;
+    }
+}
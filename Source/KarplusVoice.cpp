@@ -1,92 +1,364 @@
 #include "KarplusVoice.h"
 
-KarplusVoice::KarplusVoice(double sampleRate)
+KarplusVoice::KarplusVoice(double sampleRate, float* delayLine, int delayLineLength)
 {
     // Class Definition
     this->sampleRate = sampleRate;
+    renderRate = sampleRate;
+    rateDivision = 1;
 
-    delayBufferLength = static_cast<int>(1.0 * sampleRate);
-    delayBuffer.setSize(1, delayBufferLength);
-    delayBuffer.clear();
+    jassert(juce::isPowerOfTwo(delayLineLength));
+    delayData = delayLine;
+    halfData = nullptr;
+    roundingError = 0.0f;
+    delayBufferLength = delayLineLength;
+    delayMask = delayLineLength - 1;
+    delayLength = 1;
     delayReadPosition = 0;
     delayWritePosition = 0;
 
-    NoiseGain = 0.0f;
-    inputPhase = 0.0f;
+    frequencyValue = 0.0f;
+    currentGain = 0.0f;
+    decay = 0.0f;
     active = false;
 
-    feedbackCoefficients = juce::dsp::IIR::Coefficients<float>::makeLowPass(sampleRate, 2000.0f);
-    feedbackFilter.coefficients = feedbackCoefficients;
-    feedbackFilter.reset();
+    excitation.resize(static_cast<size_t>(ExciterBank::getMaxBurstLength(sampleRate)));
+    excitationLength = 0;
+    excitationPosition = 0;
+    noiseSeed = 0x9E3779B9u ^ static_cast<juce::uint32>(reinterpret_cast<juce::pointer_sized_uint>(this));
+    if (noiseSeed == 0) noiseSeed = 1;
+
+    noteNumber = -1;
+    outputGroup = 0;
+    released = false;
+    fadingOut = false;
+    gainStep = 0.0f;
+    level = 0.0f;
+    blockEnergy = 0.0f;
+    blockSamples = 0;
+    holdSamples = 0;
+    startOrder = 0;
+
+    h0 = 1.0f;
+    h1 = h2 = h3 = 0.0f;
+    interpolatorFeedback = 0.0f;
+    interpolatorState = 0.0f;
+
+    b0 = b1 = b2 = a1 = a2 = 0.0f;
+    z1 = z2 = 0.0f;
+
+    tracePosition = 0;
+    traceKey = 0;
+    traceable = false;
+}
+
+KarplusVoice::KarplusVoice(double sampleRate, juce::uint16* halfDelayLine, int delayLineLength)
+    : KarplusVoice(sampleRate, static_cast<float*>(nullptr), delayLineLength)
+{
+    halfData = halfDelayLine;
 }
 
-void KarplusVoice::startNote(int midiNote, float velocity, float decay, float width, int source, float cutoff)
+void KarplusVoice::startNote(int midiNote, float velocity, float decay, float width, int source, const BiquadCoefficients& feedbackCoefficients, const FractionalDelay& loop, const ExciterBank& exciters)
 {
     // Start note routine
+    releaseTrace();
     frequencyValue = juce::MidiMessage::getMidiNoteInHertz(midiNote);
-    delayTime = 1.0 / frequencyValue;
-    NoiseGain = 1.0f;
     currentGain = velocity;
-    delayWritePosition = 0;
     active = true;
 
+    noteNumber = midiNote;
+    released = false;
+    fadingOut = false;
+    gainStep = 0.0f;
+    level = 0.0f;
+    blockEnergy = 0.0f;
+    blockSamples = 0;
+
     this->decay = decay;
-    this->width = width;
-    this->source = source;
+
+    // Render the whole excitation burst now
+    excitationLength = exciters.render(excitation.data(), static_cast<int>(excitation.size()), source,
+                                       frequencyValue, width, renderRate, noiseSeed);
+    excitationPosition = 0;
+
+    // Loop length and interpolator come precomputed from the tuning table
+    delayLength = loop.length;
+    delayWritePosition = 0;
+    delayReadPosition = delayBufferLength - delayLength;
+    holdSamples = excitationLength + delayLength;
+
+    // Only the last loop's worth of the line is read before it is rewritten
+    if (halfData != nullptr)
+        std::fill(halfData + delayReadPosition - 3, halfData + delayReadPosition + delayLength, juce::uint16 {});
+    else
+        juce::FloatVectorOperations::clear(delayData + delayReadPosition - 3, delayLength + 3);
+
+    roundingError = 0.0f;
+
+    h0 = loop.taps[0]; h1 = loop.taps[1];
+    h2 = loop.taps[2]; h3 = loop.taps[3];
+    interpolatorFeedback = loop.feedback;
+    interpolatorState = 0.0f;
 
     // Update feedback filter per note dynamically
-    feedbackCoefficients = juce::dsp::IIR::Coefficients<float>::makeLowPass(sampleRate, cutoff);
-    *feedbackFilter.coefficients = *feedbackCoefficients;
-    feedbackFilter.reset();
+    b0 = feedbackCoefficients.b0; b1 = feedbackCoefficients.b1; b2 = feedbackCoefficients.b2;
+    a1 = feedbackCoefficients.a1; a2 = feedbackCoefficients.a2;
+    z1 = z2 = 0.0f;
+
+    // Noise bursts differ every time, the other sources are fully set by the settings and the burst
+    traceable = source != ExciterBank::noise;
+    traceKey = 0;
+
+    if (traceable)
+    {
+        // FNV-1a over the settings and the burst
+        juce::uint64 hash = 14695981039346656037ull;
+        auto add = [&hash](const void* data, size_t size)
+        {
+            for (size_t i = 0; i < size; ++i)
+            {
+                hash ^= static_cast<const juce::uint8*>(data)[i];
+                hash *= 1099511628211ull;
+            }
+        };
+
+        const auto settings = getLoopSettings();
+        add(&settings.loop.length, sizeof(int));
+        add(settings.loop.taps, sizeof(settings.loop.taps));
+        add(&settings.loop.feedback, sizeof(float));
+        add(&settings.loopFilter, sizeof(BiquadCoefficients));
+        add(&settings.decay, sizeof(float));
+        add(&excitationLength, sizeof(int));
+        add(excitation.data(), sizeof(float) * static_cast<size_t>(excitationLength));
+        traceKey = hash;
+    }
+}
+
+bool KarplusVoice::LoopSettings::operator== (const LoopSettings& other) const
+{
+    return loop.length == other.loop.length && std::equal(loop.taps, loop.taps + 4, other.loop.taps) && loop.feedback == other.loop.feedback
+        && loopFilter.b0 == other.loopFilter.b0 && loopFilter.b1 == other.loopFilter.b1 && loopFilter.b2 == other.loopFilter.b2
+        && loopFilter.a1 == other.loopFilter.a1 && loopFilter.a2 == other.loopFilter.a2 && decay == other.decay;
+}
+
+KarplusVoice::LoopSettings KarplusVoice::getLoopSettings() const
+{
+    LoopSettings settings;
+    settings.loop.length = delayLength;
+    settings.loop.taps[0] = h0; settings.loop.taps[1] = h1;
+    settings.loop.taps[2] = h2; settings.loop.taps[3] = h3;
+    settings.loop.feedback = interpolatorFeedback;
+    settings.loopFilter = { b0, b1, b2, a1, a2 };
+    settings.decay = decay;
+    return settings;
+}
+
+void KarplusVoice::playTrace(const NoteTrace& newTrace)
+{
+    releaseTrace();
+    trace = newTrace;
+    tracePosition = 0;
+    trace.users->fetch_add(1, std::memory_order_relaxed);
+}
+
+void KarplusVoice::releaseTrace()
+{
+    if (trace.users != nullptr)
+        trace.users->fetch_sub(1, std::memory_order_release);
+
+    trace = {};
+}
+
+int KarplusVoice::renderFromTrace(float* out, int numSamples)
+{
+    const int n = juce::jmin(numSamples, trace.length - tracePosition);
+    const float* traced = trace.output + tracePosition;
+    float energy = 0.0f;
+
+    for (int sample = 0; sample < n; ++sample)
+    {
+        const float output = traced[sample] * currentGain;
+        currentGain = juce::jmax(0.0f, currentGain + gainStep);
+        energy += output * output;
+        out[sample] += output;
+    }
+
+    tracePosition += n;
+    blockEnergy += energy;
+    blockSamples += n;
+    holdSamples -= n;
+    return n;
+}
+
+void KarplusVoice::resumeFromTrace()
+{
+    // The loop wrote burst + decay * output, and the filter state follows from its last two inputs and outputs,
+    // so the live state after tracePosition samples can be rebuilt from the trace alone
+    const int position = tracePosition;
+    auto x = [this](int t) { return t >= 0 ? trace.interpolator[t] : 0.0f; };
+    auto y = [this](int t) { return t >= 0 ? trace.output[t] : 0.0f; };
+
+    interpolatorState = x(position - 1);
+    const float previousZ2 = b2 * x(position - 2) - a2 * y(position - 2);
+    z1 = b1 * x(position - 1) - a1 * y(position - 1) + previousZ2;
+    z2 = b2 * x(position - 1) - a2 * y(position - 1);
+
+    // Only the last loop's worth of the line is read again, what came before the note was cleared at startNote
+    roundingError = 0.0f;
+
+    for (int t = juce::jmax(0, position - delayLength - 3); t < position; ++t)
+        storeDelay(t & delayMask, (t < excitationLength ? excitation[static_cast<size_t>(t)] : 0.0f) + y(t) * decay);
+
+    delayWritePosition = position & delayMask;
+    delayReadPosition = (delayBufferLength - delayLength + position) & delayMask;
+    excitationPosition = juce::jmin(position, excitationLength);
+    releaseTrace();
+}
+
+void KarplusVoice::renderTrace(const LoopSettings& settings, const float* burst, int burstLength, float* delayLine, int delayLineLength,
+                               float* output, float* interpolator, int numSamples)
+{
+    // The same loop as renderBlock, from a cleared line
+    const int mask = delayLineLength - 1;
+    const auto& loop = settings.loop;
+    const auto& c = settings.loopFilter;
+    int read = delayLineLength - loop.length, write = 0;
+    float state = 0.0f, filterZ1 = 0.0f, filterZ2 = 0.0f;
+
+    juce::FloatVectorOperations::clear(delayLine, delayLineLength);
+
+    for (int sample = 0; sample < numSamples; ++sample)
+    {
+        const float in = sample < burstLength ? burst[sample] : 0.0f;
+
+        const float delayedSample = loop.taps[0] * delayLine[read] + loop.taps[1] * delayLine[(read - 1) & mask]
+                                  + loop.taps[2] * delayLine[(read - 2) & mask] + loop.taps[3] * delayLine[(read - 3) & mask]
+                                  - loop.feedback * state;
+        state = delayedSample;
+
+        const float filteredFeedback = c.b0 * delayedSample + filterZ1;
+        filterZ1 = c.b1 * delayedSample - c.a1 * filteredFeedback + filterZ2;
+        filterZ2 = c.b2 * delayedSample - c.a2 * filteredFeedback;
+
+        delayLine[write] = in + filteredFeedback * settings.decay;
+        read = (read + 1) & mask;
+        write = (write + 1) & mask;
+
+        output[sample] = filteredFeedback;
+        interpolator[sample] = delayedSample;
+    }
+}
+
+void KarplusVoice::setRateDivision(int division)
+{
+    rateDivision = division;
+    renderRate = sampleRate / division;
 }
 
 void KarplusVoice::stopNote()
 {
-    // Start note routine
-    active = false;
+    if (isPlayingTrace())
+        resumeFromTrace();
 
+    // Release: damp the loop so the string dies out over releaseTime
+    released = true;
+    const float releaseDecay = std::pow(0.001f, static_cast<float>(delayLength) / (releaseTime * static_cast<float>(renderRate)));
+    decay = juce::jmin(decay, releaseDecay);
 }
 
-float KarplusVoice::renderNextSample(float sampleRate)
+void KarplusVoice::fadeOut(float fadeTime)
 {
-    if (!active)
-        return 0.0f;
+    // Short ramp to silence, used when the voice is stolen
+    fadingOut = true;
+    gainStep = -currentGain / juce::jmax(1.0f, fadeTime * static_cast<float>(renderRate));
+}
+
+float KarplusVoice::readDelay(int delay) const
+{
+    return loadDelay((delayReadPosition - delay) & delayMask);
+}
+
+void KarplusVoice::storeDelay(int position, float value)
+{
+    if (halfData != nullptr)
+        halfData[position] = HalfFloat::fromFloatShaped(value, roundingError);
+    else
+        delayData[position] = value;
+}
 
-    delayReadPosition = (delayWritePosition - static_cast<int>(delayTime * sampleRate) + delayBufferLength) % delayBufferLength;
+void KarplusVoice::renderBlock(float* out, int numSamples)
+{
+    if (!active)
+        return;
 
-    float in = 0.0f;
-    if (NoiseGain > 0.0f)
+    if (isPlayingTrace())
     {
-        switch (source)
-        {
-            // Four different exciters
-            case 0: in = sinf(juce::MathConstants<float>::twoPi * inputPhase); break;                            // Sine
-            case 1: in = fmod(inputPhase * 2.0f, 2.0f) - 1.0f; break;                                            // Sawtooth
-            case 2: in = (sinf(juce::MathConstants<float>::twoPi * inputPhase) >= 0.0f) ? 1.0f : -1.0f; break;   // Square
-            case 3: in = 2.0f * (juce::Random::getSystemRandom().nextFloat() - 0.5f); break;                     // Noise
-        }
-        NoiseGain -= 1.0f / (width * sampleRate);
-        if (NoiseGain < 0.0f) NoiseGain = 0.0f;
+        const int played = renderFromTrace(out, numSamples);
+
+        if (played == numSamples)
+            return;
+
+        // The trace ran out within this block
+        resumeFromTrace();
+        out += played;
+        numSamples -= played;
     }
-    
-    // Adjust phase
-    inputPhase += frequencyValue / sampleRate;
-    if (inputPhase >= 1.0f) inputPhase -= 1.0f;
 
-    float delayedSample = delayBuffer.getSample(0, delayReadPosition);
+    float energy = 0.0f;
+
+    for (int sample = 0; sample < numSamples; ++sample)
+    {
+        const float in = nextExcitationSample();
+
+        // Fractional delay
+        const float delayedSample = h0 * loadDelay(delayReadPosition) + h1 * readDelay(1) + h2 * readDelay(2) + h3 * readDelay(3)
+                                  - interpolatorFeedback * interpolatorState;
+        interpolatorState = delayedSample;
+
+        // Apply filtered feedback
+        const float filteredFeedback = b0 * delayedSample + z1;
+        z1 = b1 * delayedSample - a1 * filteredFeedback + z2;
+        z2 = b2 * delayedSample - a2 * filteredFeedback;
 
-    // Apply filtered feedback
-    float filteredFeedback = feedbackFilter.processSample(delayedSample);
+        storeDelay(delayWritePosition, in + filteredFeedback * decay);
 
-    delayBuffer.setSample(0, delayWritePosition, in + filteredFeedback * decay);
+        delayReadPosition = (delayReadPosition + 1) & delayMask;
+        delayWritePosition = (delayWritePosition + 1) & delayMask;
 
-    delayReadPosition = (delayReadPosition + 1) % delayBufferLength;
-    delayWritePosition = (delayWritePosition + 1) % delayBufferLength;
+        const float output = filteredFeedback * currentGain;
+        currentGain = juce::jmax(0.0f, currentGain + gainStep);
+        energy += output * output;
+        out[sample] += output;
+    }
 
-    return filteredFeedback * currentGain;
+    blockEnergy += energy;
+    blockSamples += numSamples;
+    holdSamples -= numSamples;
 }
 
 bool KarplusVoice::isActive() const
 {
     return active;
 }
+
+void KarplusVoice::endBlock()
+{
+    level = blockEnergy / static_cast<float>(juce::jmax(1, blockSamples));
+    blockEnergy = 0.0f;
+    blockSamples = 0;
+}
+
+bool KarplusVoice::isFinished() const
+{
+    if (fadingOut)
+        return currentGain <= 0.0f;
+
+    return holdSamples <= 0 && level < silenceThreshold;
+}
+
+void KarplusVoice::deactivate()
+{
+    releaseTrace();
+    active = false;
+    noteNumber = -1;
+}
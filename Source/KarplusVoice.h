@@ -1,25 +1,134 @@
 #pragma once
 #include <JuceHeader.h>
+#include "TuningTable.h"
+#include "Biquad.h"
+#include "ExciterBank.h"
+#include "HalfFloat.h"
+
+// Opening of a note rendered ahead of time at unit gain, see NoteCache. The interpolator output is
+// kept next to the string output, so live synthesis can take over from any sample of it.
+struct NoteTrace
+{
+    const float* output = nullptr;
+    const float* interpolator = nullptr;
+    int length = 0;
+    std::atomic<int>* users = nullptr;
+};
 
 class KarplusVoice
 {
 public:
-    KarplusVoice(double sampleRate);
-    void startNote(int midiNote, float velocity, float decay, float width, int source, float cutoff);
+    // Everything apart from the excitation burst that decides how a note sounds until it is released
+    struct LoopSettings
+    {
+        FractionalDelay loop;
+        BiquadCoefficients loopFilter;
+        float decay = 0.0f;
+
+        bool operator== (const LoopSettings& other) const;
+    };
+
+    // The delay line is owned by a DelayLinePool, its length must be a power of two
+    KarplusVoice(double sampleRate, float* delayLine, int delayLineLength);
+    KarplusVoice(double sampleRate, juce::uint16* halfDelayLine, int delayLineLength);
+    void startNote(int midiNote, float velocity, float decay, float width, int source, const BiquadCoefficients& feedbackCoefficients, const FractionalDelay& loop, const ExciterBank& exciters);
     void stopNote();
-    float renderNextSample(float sampleRate);
+    void fadeOut(float fadeTime);
+    void renderBlock(float* out, int numSamples);
     bool isActive() const;
+    bool isFinished() const;
+    void deactivate();
+
+    // Closes a host block: the level becomes the mean square of everything rendered since the last call,
+    // however many stretches the block was split into
+    void endBlock();
+
+    int getNoteNumber() const    { return noteNumber; }
+    bool isReleased() const      { return released; }
+    bool isFadingOut() const     { return fadingOut; }
+    float getLevel() const       { return level; }
+
+    // Which output bus the voice is mixed into, from the MIDI channel of its note
+    void setOutputGroup(int group)  { outputGroup = group; }
+    int getOutputGroup() const      { return outputGroup; }
+
+    // The string can run at the host rate divided by 1, 2 or 4, set before startNote
+    void setRateDivision(int division);
+    int getRateDivision() const     { return rateDivision; }
+
+    // Notes with a pitched source sound the same every time they start with the same settings
+    bool isTraceable() const                    { return traceable; }
+    juce::uint64 getTraceKey() const            { return traceKey; }
+    LoopSettings getLoopSettings() const;
+    const float* getExcitation() const          { return excitation.data(); }
+    int getExcitationLength() const             { return excitationLength; }
+
+    // Plays the note from a trace of it, right after startNote. Live synthesis takes over where the
+    // trace ends or at note-off, whichever comes first.
+    void playTrace(const NoteTrace& newTrace);
+    bool isPlayingTrace() const                 { return trace.output != nullptr; }
+
+    // Renders what a voice started with these settings and burst plays, at unit gain and until note-off.
+    // Always in float, whatever the format of the voices' own lines.
+    static void renderTrace(const LoopSettings& settings, const float* burst, int burstLength, float* delayLine, int delayLineLength,
+                            float* output, float* interpolator, int numSamples);
+
+    // Loop damping after note-off, and the level below which a finished string is freed
+    static constexpr float releaseTime = 0.15f;
+    static constexpr float silenceThreshold = 1.0e-9f; // -90 dB mean square
 
 private:
-    juce::AudioBuffer<float> delayBuffer;
-    int delayBufferLength, delayReadPosition, delayWritePosition;
-    float NoiseGain, inputPhase, frequencyValue, delayTime, currentGain;
-    float decay, width;
-    int source;
+    // The voice bank renders groups of voices in SIMD lanes straight from this state
+    friend class VoiceBank;
+    // The allocator keeps its steal order on the voice, so finding a victim is one pass over the active voices
+    friend class VoiceAllocator;
+
+    float nextExcitationSample() { return excitationPosition < excitationLength ? excitation[static_cast<size_t>(excitationPosition++)] : 0.0f; }
+    float readDelay(int delay) const;
+    float loadDelay(int position) const   { return halfData != nullptr ? HalfFloat::toFloat(halfData[position]) : delayData[position]; }
+    void storeDelay(int position, float value);
+
+    // Returns the number of samples the trace had left to give, up to numSamples
+    int renderFromTrace(float* out, int numSamples);
+    void resumeFromTrace();
+    void releaseTrace();
+
+    float* delayData;
+    juce::uint16* halfData;  // instead of delayData for a half float line
+    float roundingError;     // noise shaping state of the half float line
+    int delayBufferLength, delayMask, delayLength, delayReadPosition, delayWritePosition;
+    float frequencyValue, currentGain;
+    float decay;
     bool active;
-    double sampleRate;
-    
 
-    juce::dsp::IIR::Filter<float> feedbackFilter;
-    juce::dsp::IIR::Coefficients<float>::Ptr feedbackCoefficients;
+    // Excitation burst, rendered at note start
+    std::vector<float> excitation;
+    int excitationLength, excitationPosition;
+    juce::uint32 noiseSeed;
+    double sampleRate, renderRate;
+    int rateDivision;
+
+    // Voice allocation
+    int noteNumber, outputGroup;
+    bool released, fadingOut;
+    float gainStep;      // per-sample output gain ramp while fading out
+    float level;         // mean square of the last host block
+    float blockEnergy;   // output energy and samples rendered so far in this host block
+    int blockSamples;
+    int holdSamples;     // the loop is still filling, don't judge the level yet
+    juce::uint32 startOrder; // note-on count when this voice was last started, the oldest is stolen first
+
+    // Fractional delay interpolator, see FractionalDelay
+    float h0, h1, h2, h3, interpolatorFeedback;
+    float interpolatorState;
+
+    // Feedback low-pass, transposed direct form II
+    float b0, b1, b2, a1, a2;
+    float z1, z2;
+
+    // Playback from a NoteCache trace
+    NoteTrace trace;
+    int tracePosition;
+    juce::uint64 traceKey;
+    bool traceable;
 };
@@ -0,0 +1,154 @@
+#include "NoteCache.h"
+#include "RealtimeSemaphore.h"
+
+class NoteCache::RenderThread : public juce::Thread
+{
+public:
+    explicit RenderThread(NoteCache& ownerToUse) : juce::Thread("Pluck note cache"), owner(ownerToUse)
+    {
+    }
+
+    void wake()
+    {
+        wakeUp.signal();
+    }
+
+    void stop()
+    {
+        signalThreadShouldExit();
+        wakeUp.signal();
+        stopThread(1000);
+    }
+
+    void run() override
+    {
+        juce::ScopedNoDenormals noDenormals;
+
+        while (!threadShouldExit())
+        {
+            wakeUp.wait();
+            owner.renderQueued();
+        }
+    }
+
+private:
+    NoteCache& owner;
+    RealtimeSemaphore wakeUp;
+};
+
+NoteCache::NoteCache()
+    : thread(std::make_unique<RenderThread>(*this))
+{
+}
+
+NoteCache::~NoteCache()
+{
+    thread->stop();
+}
+
+void NoteCache::prepare(double sampleRate, int delayLineLength, int numEntries, float seconds)
+{
+    thread->stop();
+
+    const int newTraceLength = juce::jmax(1, static_cast<int>(seconds * sampleRate));
+    const auto burstLength = static_cast<size_t>(ExciterBank::getMaxBurstLength(sampleRate));
+
+    // Re-prepared at the same rate: the stored notes are still valid, keep them
+    if (newTraceLength == traceLength && renderLine.size() == static_cast<size_t>(delayLineLength)
+        && static_cast<int>(entries.size()) == numEntries && numEntries > 0 && entries.front()->burst.size() == burstLength)
+    {
+        thread->startThread(juce::Thread::Priority::low);
+        return;
+    }
+
+    traceLength = newTraceLength;
+    renderLine.assign(static_cast<size_t>(delayLineLength), 0.0f);
+
+    entries.clear();
+    for (int i = 0; i < numEntries; ++i)
+    {
+        auto entry = std::make_unique<Entry>();
+        entry->burst.resize(burstLength);
+        entries.push_back(std::move(entry));
+    }
+
+    clock = 0;
+    thread->startThread(juce::Thread::Priority::low);
+}
+
+void NoteCache::release()
+{
+    thread->stop();
+}
+
+bool NoteCache::start(KarplusVoice& voice)
+{
+    if (! voice.isTraceable() || ! thread->isThreadRunning())
+        return false;
+
+    const auto key = voice.getTraceKey();
+    const auto settings = voice.getLoopSettings();
+    Entry* victim = nullptr;
+
+    for (auto& entry : entries)
+    {
+        const int state = entry->state.load(std::memory_order_acquire);
+
+        if (state != empty && entry->key == key && entry->rateDivision == voice.getRateDivision()
+            && entry->burstLength == voice.getExcitationLength() && entry->settings == settings)
+        {
+            // Still being rendered, this note plays live
+            if (state != ready)
+                return false;
+
+            entry->lastUsed = ++clock;
+            voice.playTrace({ entry->output.data(), entry->interpolator.data(), entry->length, &entry->users });
+            return true;
+        }
+
+        // Empty entries were never used, so they go first
+        const bool recyclable = state == empty || (state == ready && entry->users.load(std::memory_order_acquire) == 0);
+
+        if (recyclable && (victim == nullptr || entry->lastUsed < victim->lastUsed))
+            victim = entry.get();
+    }
+
+    // Every entry is queued or playing, the note plays live without being cached
+    if (victim == nullptr || voice.getExcitationLength() > static_cast<int>(victim->burst.size()))
+        return false;
+
+    victim->key = key;
+    victim->settings = settings;
+    victim->rateDivision = voice.getRateDivision();
+    victim->length = getTraceLength(victim->rateDivision);
+    victim->burstLength = voice.getExcitationLength();
+    std::copy(voice.getExcitation(), voice.getExcitation() + victim->burstLength, victim->burst.begin());
+    victim->lastUsed = ++clock;
+    victim->state.store(queued, std::memory_order_release);
+    thread->wake();
+    return false;
+}
+
+void NoteCache::renderQueued()
+{
+    for (auto& entry : entries)
+    {
+        int expected = queued;
+
+        if (! entry->state.compare_exchange_strong(expected, rendering, std::memory_order_acquire))
+            continue;
+
+        // Allocated on first use, and again when a voice at another rate takes the entry over
+        if (entry->output.size() != static_cast<size_t>(entry->length))
+        {
+            entry->output = std::vector<float>(static_cast<size_t>(entry->length));
+            entry->interpolator = std::vector<float>(static_cast<size_t>(entry->length));
+        }
+
+        KarplusVoice::renderTrace(entry->settings, entry->burst.data(), entry->burstLength,
+                                  renderLine.data(), static_cast<int>(renderLine.size()),
+                                  entry->output.data(), entry->interpolator.data(), entry->length);
+
+        entry->state.store(ready, std::memory_order_release);
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <JuceHeader.h>
+#include "KarplusVoice.h"
+
+// Openings of recently played notes, rendered once on a background thread and replayed by voices that
+// start with the same loop, filter, decay and burst. A fixed set of entries is recycled least recently
+// used first. Entry memory is allocated by the render thread on first use, so an unused cache costs
+// almost nothing and the audio thread never allocates.
+class NoteCache
+{
+public:
+    static constexpr int defaultEntries = 32;
+    static constexpr float defaultSeconds = 1.0f;
+
+    NoteCache();
+    ~NoteCache();
+
+    // Sizes the entries and starts the render thread, not real-time safe. No voice may still be playing a trace.
+    void prepare(double sampleRate, int delayLineLength, int numEntries = defaultEntries, float seconds = defaultSeconds);
+    void release();
+
+    // Audio thread, right after startNote. Hands the voice a finished trace of its note and returns true,
+    // or queues one to be rendered for the next time the note starts like this.
+    bool start(KarplusVoice& voice);
+
+    // Trace length in samples of a voice running at the host rate divided by rateDivision
+    int getTraceLength(int rateDivision) const    { return traceLength / rateDivision; }
+
+private:
+    class RenderThread;
+
+    enum State
+    {
+        empty = 0,
+        queued,
+        rendering,
+        ready
+    };
+
+    struct Entry
+    {
+        // Written by the audio thread before the entry is queued, read by the render thread while it renders
+        juce::uint64 key = 0;
+        KarplusVoice::LoopSettings settings;
+        int rateDivision = 1, length = 0;
+        std::vector<float> burst;
+        int burstLength = 0;
+
+        // Written by the render thread, read by voices once the entry is ready
+        std::vector<float> output, interpolator;
+
+        std::atomic<int> state { empty };
+        std::atomic<int> users { 0 };   // voices playing this trace
+        juce::uint64 lastUsed = 0;      // audio thread only
+    };
+
+    void renderQueued();
+
+    std::vector<std::unique_ptr<Entry>> entries;
+    std::unique_ptr<RenderThread> thread;
+    std::vector<float> renderLine;  // the render thread's delay line
+    int traceLength = 0;            // at the host rate
+    juce::uint64 clock = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(NoteCache)
+};
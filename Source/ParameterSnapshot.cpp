@@ -0,0 +1,103 @@
+#include "ParameterSnapshot.h"
+
+CachedParameters::CachedParameters(juce::AudioProcessorValueTreeState& apvts)
+    : gain(apvts.getRawParameterValue("gain")),
+      source(apvts.getRawParameterValue("source")),
+      decay(apvts.getRawParameterValue("decay")),
+      width(apvts.getRawParameterValue("width")),
+      filterCutoff(apvts.getRawParameterValue("filterCutoff")),
+      tuning(apvts.getRawParameterValue("tuning")),
+      polyphony(apvts.getRawParameterValue("polyphony")),
+      voiceStealing(apvts.getRawParameterValue("voiceStealing")),
+      renderThreads(apvts.getRawParameterValue("renderThreads")),
+      voiceRate(apvts.getRawParameterValue("voiceRate")),
+      quality(apvts.getRawParameterValue("quality")),
+      noteCache(apvts.getRawParameterValue("noteCache")),
+      loopStorage(apvts.getRawParameterValue("loopStorage")),
+      lowFilterCutoff(apvts.getRawParameterValue("lowFilterCutoff")),
+      tremoloRate(apvts.getRawParameterValue("tremoloRate")),
+      tremoloDepth(apvts.getRawParameterValue("tremoloDepth")),
+      reverbSize(apvts.getRawParameterValue("reverbSize")),
+      reverbMix(apvts.getRawParameterValue("reverbMix")),
+      body(apvts.getRawParameterValue("body")),
+      bodyMix(apvts.getRawParameterValue("bodyMix")),
+      sympathetic(apvts.getRawParameterValue("sympathetic")),
+      sympatheticLevel(apvts.getRawParameterValue("sympatheticLevel"))
+{
+}
+
+bool ParameterSnapshot::set(const juce::String& parameterID, float value)
+{
+    if (parameterID == "gain")                 gain = value;
+    else if (parameterID == "source")          source = static_cast<int>(value);
+    else if (parameterID == "decay")           decay = value;
+    else if (parameterID == "width")           width = value;
+    else if (parameterID == "filterCutoff")    filterCutoff = value;
+    else if (parameterID == "tuning")          tuning = static_cast<int>(value);
+    else if (parameterID == "polyphony")       polyphony = static_cast<int>(value);
+    else if (parameterID == "voiceStealing")   voiceStealing = static_cast<int>(value);
+    else if (parameterID == "renderThreads")   renderThreads = static_cast<int>(value);
+    else if (parameterID == "voiceRate")       voiceRate = static_cast<int>(value);
+    else if (parameterID == "quality")         quality = static_cast<int>(value);
+    else if (parameterID == "noteCache")       noteCache = static_cast<int>(value);
+    else if (parameterID == "loopStorage")     loopStorage = static_cast<int>(value);
+    else if (parameterID == "lowFilterCutoff") lowFilterCutoff = value;
+    else if (parameterID == "tremoloRate")     tremoloRate = value;
+    else if (parameterID == "tremoloDepth")    tremoloDepth = value;
+    else if (parameterID == "reverbSize")      reverbSize = value;
+    else if (parameterID == "reverbMix")       reverbMix = value;
+    else if (parameterID == "body")            body = static_cast<int>(value);
+    else if (parameterID == "bodyMix")         bodyMix = value;
+    else if (parameterID == "sympathetic")     sympathetic = static_cast<int>(value);
+    else if (parameterID == "sympatheticLevel") sympatheticLevel = value;
+    else return false;
+
+    return true;
+}
+
+void ParameterSnapshot::applySound(const ParameterSnapshot& preset)
+{
+    gain = preset.gain;
+    source = preset.source;
+    decay = preset.decay;
+    width = preset.width;
+    filterCutoff = preset.filterCutoff;
+    tuning = preset.tuning;
+    lowFilterCutoff = preset.lowFilterCutoff;
+    tremoloRate = preset.tremoloRate;
+    tremoloDepth = preset.tremoloDepth;
+    reverbSize = preset.reverbSize;
+    reverbMix = preset.reverbMix;
+    body = preset.body;
+    bodyMix = preset.bodyMix;
+    sympathetic = preset.sympathetic;
+    sympatheticLevel = preset.sympatheticLevel;
+}
+
+ParameterSnapshot CachedParameters::snapshot() const
+{
+    ParameterSnapshot p;
+    p.gain = gain->load();
+    p.source = static_cast<int>(source->load());
+    p.decay = decay->load();
+    p.width = width->load();
+    p.filterCutoff = filterCutoff->load();
+    p.tuning = static_cast<int>(tuning->load());
+    p.polyphony = static_cast<int>(polyphony->load());
+    p.voiceStealing = static_cast<int>(voiceStealing->load());
+    p.renderThreads = static_cast<int>(renderThreads->load());
+    p.voiceRate = static_cast<int>(voiceRate->load());
+    p.quality = static_cast<int>(quality->load());
+    p.noteCache = static_cast<int>(noteCache->load());
+    p.loopStorage = static_cast<int>(loopStorage->load());
+    p.lowFilterCutoff = lowFilterCutoff->load();
+    p.tremoloRate = tremoloRate->load();
+    p.tremoloDepth = tremoloDepth->load();
+    p.reverbSize = reverbSize->load();
+    p.reverbMix = reverbMix->load();
+    p.body = static_cast<int>(body->load());
+    p.bodyMix = bodyMix->load();
+    p.sympathetic = static_cast<int>(sympathetic->load());
+    p.sympatheticLevel = sympatheticLevel->load();
+    return p;
+}
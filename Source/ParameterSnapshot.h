@@ -0,0 +1,49 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Plain copy of every parameter, taken once at the top of processBlock
+struct ParameterSnapshot
+{
+    float gain, decay, width, filterCutoff, lowFilterCutoff;
+    float tremoloRate, tremoloDepth, reverbSize, reverbMix, bodyMix, sympatheticLevel;
+    int source, tuning, polyphony, voiceStealing, renderThreads, voiceRate, quality, noteCache, loopStorage, body, sympathetic;
+
+    // Sets the field of one parameter by ID, returns false for IDs the snapshot doesn't hold
+    bool set(const juce::String& parameterID, float value);
+
+    // Takes the sound settings of a preset and keeps the engine settings
+    void applySound(const ParameterSnapshot& preset);
+};
+
+// Looks the raw parameter atomics up once, so the audio thread never searches by ID
+class CachedParameters
+{
+public:
+    explicit CachedParameters(juce::AudioProcessorValueTreeState& apvts);
+
+    ParameterSnapshot snapshot() const;
+
+private:
+    std::atomic<float>* gain;
+    std::atomic<float>* source;
+    std::atomic<float>* decay;
+    std::atomic<float>* width;
+    std::atomic<float>* filterCutoff;
+    std::atomic<float>* tuning;
+    std::atomic<float>* polyphony;
+    std::atomic<float>* voiceStealing;
+    std::atomic<float>* renderThreads;
+    std::atomic<float>* voiceRate;
+    std::atomic<float>* quality;
+    std::atomic<float>* noteCache;
+    std::atomic<float>* loopStorage;
+    std::atomic<float>* lowFilterCutoff;
+    std::atomic<float>* tremoloRate;
+    std::atomic<float>* tremoloDepth;
+    std::atomic<float>* reverbSize;
+    std::atomic<float>* reverbMix;
+    std::atomic<float>* body;
+    std::atomic<float>* bodyMix;
+    std::atomic<float>* sympathetic;
+    std::atomic<float>* sympatheticLevel;
+};
@@ -0,0 +1,120 @@
+#include "PartitionedConvolver.h"
+
+void PartitionedConvolver::prepare(int newBlockSize, int newMaxPartitions)
+{
+    blockSize = juce::nextPowerOfTwo(juce::jmax(1, newBlockSize));
+    maxPartitions = juce::jmax(1, newMaxPartitions);
+    numBins = blockSize + 1;
+
+    const int fftSize = 2 * blockSize;
+    fft = std::make_unique<juce::dsp::FFT>(juce::roundToInt(std::log2(fftSize)));
+    fftBuffer.assign(static_cast<size_t>(2 * fftSize), 0.0f);
+    previousInput.assign(static_cast<size_t>(blockSize), 0.0f);
+    delayReal.assign(static_cast<size_t>(maxPartitions * numBins), 0.0f);
+    delayImag.assign(static_cast<size_t>(maxPartitions * numBins), 0.0f);
+    sumReal.assign(static_cast<size_t>(numBins), 0.0f);
+    sumImag.assign(static_cast<size_t>(numBins), 0.0f);
+
+    // Measure the round trip gain once, so it can be folded into the partitions
+    fftBuffer[0] = 1.0f;
+    fft->performRealOnlyForwardTransform(fftBuffer.data(), true);
+    fft->performRealOnlyInverseTransform(fftBuffer.data());
+    inverseScale = 1.0f / fftBuffer[0];
+
+    impulse = nullptr;
+    reset();
+}
+
+void PartitionedConvolver::reset()
+{
+    std::fill(previousInput.begin(), previousInput.end(), 0.0f);
+    std::fill(delayReal.begin(), delayReal.end(), 0.0f);
+    std::fill(delayImag.begin(), delayImag.end(), 0.0f);
+    delayHead = 0;
+}
+
+void PartitionedConvolver::makeImpulse(const float* taps, int numTaps, Impulse& newImpulse)
+{
+    newImpulse.numPartitions = juce::jmin(maxPartitions, (juce::jmax(0, numTaps) + blockSize - 1) / blockSize);
+    newImpulse.real.assign(static_cast<size_t>(newImpulse.numPartitions * numBins), 0.0f);
+    newImpulse.imag.assign(static_cast<size_t>(newImpulse.numPartitions * numBins), 0.0f);
+
+    for (int partition = 0; partition < newImpulse.numPartitions; ++partition)
+    {
+        // Zero-padded to the FFT size, so the second half of every output frame is linear
+        const int first = partition * blockSize;
+        const int count = juce::jmin(blockSize, numTaps - first);
+
+        std::fill(fftBuffer.begin(), fftBuffer.end(), 0.0f);
+        for (int i = 0; i < count; ++i)
+            fftBuffer[static_cast<size_t>(i)] = taps[first + i] * inverseScale;
+
+        fft->performRealOnlyForwardTransform(fftBuffer.data(), true);
+
+        for (int bin = 0; bin < numBins; ++bin)
+        {
+            newImpulse.real[static_cast<size_t>(partition * numBins + bin)] = fftBuffer[static_cast<size_t>(2 * bin)];
+            newImpulse.imag[static_cast<size_t>(partition * numBins + bin)] = fftBuffer[static_cast<size_t>(2 * bin + 1)];
+        }
+    }
+}
+
+void PartitionedConvolver::setImpulse(const Impulse* newImpulse)
+{
+    impulse = newImpulse;
+    reset();
+}
+
+void PartitionedConvolver::process(const float* input, float* output)
+{
+    if (impulse == nullptr || impulse->numPartitions == 0)
+    {
+        juce::FloatVectorOperations::clear(output, blockSize);
+        return;
+    }
+
+    // Overlap-save frame: the previous block followed by this one
+    std::copy(previousInput.begin(), previousInput.end(), fftBuffer.begin());
+    std::copy(input, input + blockSize, fftBuffer.begin() + blockSize);
+    std::copy(input, input + blockSize, previousInput.begin());
+    fft->performRealOnlyForwardTransform(fftBuffer.data(), true);
+
+    // The newest spectrum goes in front of the delay line, partition i meets the spectrum i blocks old
+    delayHead = delayHead == 0 ? maxPartitions - 1 : delayHead - 1;
+    float* newestReal = delayReal.data() + delayHead * numBins;
+    float* newestImag = delayImag.data() + delayHead * numBins;
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        newestReal[bin] = fftBuffer[static_cast<size_t>(2 * bin)];
+        newestImag[bin] = fftBuffer[static_cast<size_t>(2 * bin + 1)];
+    }
+
+    juce::FloatVectorOperations::clear(sumReal.data(), numBins);
+    juce::FloatVectorOperations::clear(sumImag.data(), numBins);
+
+    for (int partition = 0; partition < impulse->numPartitions; ++partition)
+    {
+        const int slot = (delayHead + partition) % maxPartitions;
+        const float* xRe = delayReal.data() + slot * numBins;
+        const float* xIm = delayImag.data() + slot * numBins;
+        const float* hRe = impulse->real.data() + partition * numBins;
+        const float* hIm = impulse->imag.data() + partition * numBins;
+
+        juce::FloatVectorOperations::addWithMultiply(sumReal.data(), xRe, hRe, numBins);
+        juce::FloatVectorOperations::subtractWithMultiply(sumReal.data(), xIm, hIm, numBins);
+        juce::FloatVectorOperations::addWithMultiply(sumImag.data(), xRe, hIm, numBins);
+        juce::FloatVectorOperations::addWithMultiply(sumImag.data(), xIm, hRe, numBins);
+    }
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        fftBuffer[static_cast<size_t>(2 * bin)] = sumReal[static_cast<size_t>(bin)];
+        fftBuffer[static_cast<size_t>(2 * bin + 1)] = sumImag[static_cast<size_t>(bin)];
+    }
+
+    fft->performRealOnlyInverseTransform(fftBuffer.data());
+
+    // The first half of the frame wrapped around, the second half is the linear convolution
+    std::copy(fftBuffer.begin() + blockSize, fftBuffer.begin() + 2 * blockSize, output);
+}
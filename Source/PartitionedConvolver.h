@@ -0,0 +1,43 @@
+#pragma once
+#include <JuceHeader.h>
+#include <juce_dsp/juce_dsp.h>
+
+// Uniformly partitioned overlap-save convolution. The impulse is cut into blockSize partitions,
+// each transformed once, and every input block is transformed once into a frequency-domain delay
+// line, so a block costs one forward and one inverse FFT plus a complex multiply-add per partition.
+// Output lags the input by one block; callers hide that by starting the impulse one block in.
+class PartitionedConvolver
+{
+public:
+    // Partition spectra, numPartitions rows of numBins split into real and imaginary planes
+    struct Impulse
+    {
+        std::vector<float> real, imag;
+        int numPartitions = 0;
+    };
+
+    void prepare(int newBlockSize, int newMaxPartitions);
+    void reset();
+
+    // Message thread: transforms numTaps taps into impulse, the convolver must be prepared
+    void makeImpulse(const float* taps, int numTaps, Impulse& impulse);
+
+    // Clears the history when the impulse changes, null stops the output
+    void setImpulse(const Impulse* newImpulse);
+
+    // Reads blockSize samples and writes the blockSize samples of output they complete
+    void process(const float* input, float* output);
+
+    int getBlockSize() const    { return blockSize; }
+
+private:
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float> fftBuffer;          // 2 * fftSize, as juce::dsp::FFT expects
+    std::vector<float> previousInput;
+    std::vector<float> delayReal, delayImag;
+    std::vector<float> sumReal, sumImag;
+    const Impulse* impulse = nullptr;
+    int blockSize = 0, numBins = 0, maxPartitions = 0;
+    int delayHead = 0;
+    float inverseScale = 1.0f;
+};
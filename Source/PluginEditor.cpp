@@ -1,22 +1,77 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+void CustomLookAndFeel::drawRotarySlider(juce::Graphics& g, int x, int y, int width, int height,
+                                         float sliderPosProportional, float rotaryStartAngle,
+                                         float rotaryEndAngle, juce::Slider&)
+{
+    auto radius = juce::jmin(width / 2.0f, height / 2.0f);
+    auto centreX = x + width  * 0.5f;
+    auto centreY = y + height * 0.5f;
+    auto angle = rotaryStartAngle + sliderPosProportional * (rotaryEndAngle - rotaryStartAngle);
+
+    // Background circle, from the cache at the physical pixel size
+    const auto bounds = juce::Rectangle<float>(centreX - radius, centreY - radius, radius * 2.0f, radius * 2.0f);
+    const float pixelScale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    g.drawImage(getKnobFace(juce::roundToInt(radius * 2.0f * pixelScale)), bounds);
+
+    // Pointer
+    g.setColour(juce::Colours::white);
+    g.fillPath(getPointer(radius), juce::AffineTransform::rotation(angle).translated(centreX, centreY));
+}
+
+const juce::Image& CustomLookAndFeel::getKnobFace(int diameterInPixels)
+{
+    // Live resizing passes through many sizes, don't keep them all
+    if (knobFaces.size() > 16 && knobFaces.count(diameterInPixels) == 0)
+        knobFaces.clear();
+
+    auto& face = knobFaces[diameterInPixels];
+
+    if (! face.isValid())
+    {
+        face = juce::Image(juce::Image::ARGB, juce::jmax(1, diameterInPixels), juce::jmax(1, diameterInPixels), true);
+        juce::Graphics faceGraphics(face);
+        faceGraphics.setColour(juce::Colours::darkgrey);
+        faceGraphics.fillEllipse(face.getBounds().toFloat());
+    }
+
+    return face;
+}
+
+const juce::Path& CustomLookAndFeel::getPointer(float radius)
+{
+    if (radius != pointerRadius)
+    {
+        pointer.clear();
+        pointer.addRectangle(-2.0f, -radius, 4.0f, radius * 0.7f);
+        pointerRadius = radius;
+    }
+
+    return pointer;
+}
+
 Karplus_Bonus_AudioProcessorEditor::Karplus_Bonus_AudioProcessorEditor(Karplus_Bonus_AudioProcessor& p)
     : AudioProcessorEditor(&p), processor(p)
+#if PLUCK_TELEMETRY
+    , telemetryView(p.getTelemetry())
+#endif
 {
     auto& apvts = processor.apvts;
 
-    // Set Size
-    setSize(700, 450);
+    // Set Size, resizable at a fixed aspect ratio
+    setResizable(true, true);
+    setResizeLimits(designWidth / 2, designHeight / 2, designWidth * 2, designHeight * 2);
+    getConstrainer()->setFixedAspectRatio(static_cast<double>(designWidth) / designHeight);
+    setOpaque(true);
     
     // Keyboard
-    addAndMakeVisible(processor.keyboardComponent);
+    addAndMakeVisible(keyboardComponent);
     
-    // Background Image
-    backgroundImage = juce::ImageCache::getFromMemory(
-        BinaryData::Background_synth_png,
-        BinaryData::Background_synth_pngSize
-    );
+#if PLUCK_TELEMETRY
+    addAndMakeVisible(telemetryView);
+#endif
+
     
     // Knobs
     gainSlider.setSliderStyle(juce::Slider::Rotary);
@@ -128,6 +183,9 @@ Karplus_Bonus_AudioProcessorEditor::Karplus_Bonus_AudioProcessorEditor(Karplus_B
     reverbSizeAttach   = std::make_unique<SliderAttachment>(apvts, "reverbSize", reverbSizeSlider);
     reverbMixAttach    = std::make_unique<SliderAttachment>(apvts, "reverbMix", reverbMixSlider);
     sourceAttach       = std::make_unique<ComboBoxAttachment>(apvts, "source", sourceChoice);
+
+    // Last, so resized() sees every component
+    setSize(designWidth, designHeight);
 }
 
 //Destructor
@@ -146,17 +204,37 @@ Karplus_Bonus_AudioProcessorEditor::~Karplus_Bonus_AudioProcessorEditor()
 
 void Karplus_Bonus_AudioProcessorEditor::paint(juce::Graphics& g)
 {
+    // Re-rendered only when the size or display scale changes
+    const float pixelScale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    const int cacheWidth = juce::jmax(1, juce::roundToInt(getWidth() * pixelScale));
+    const int cacheHeight = juce::jmax(1, juce::roundToInt(getHeight() * pixelScale));
+
+    if (backgroundCache.getWidth() != cacheWidth || backgroundCache.getHeight() != cacheHeight)
+        renderBackground(cacheWidth, cacheHeight);
+
+    // Only the clipped region is copied, so a knob repaint touches just its own area
+    g.drawImage(backgroundCache, getLocalBounds().toFloat());
+}
+
+void Karplus_Bonus_AudioProcessorEditor::renderBackground(int width, int height)
+{
+    if (backgroundImage.isNull())
+        backgroundImage = juce::ImageCache::getFromMemory(BinaryData::Background_synth_png,
+                                                          BinaryData::Background_synth_pngSize);
+
+    backgroundCache = juce::Image(juce::Image::RGB, width, height, true);
+
+    juce::Graphics g(backgroundCache);
+    g.addTransform(juce::AffineTransform::scale(static_cast<float>(width) / designWidth));
+    g.fillAll(juce::Colours::black); // fallback if image fails to load
+
     if (backgroundImage.isValid())
     {
         g.drawImage(backgroundImage,
-                    0, -15, getWidth(), getHeight(),                                  // destination bounds (fills entire UI)
+                    0, -15, designWidth, designHeight,                              // destination bounds (fills entire UI)
                     0, 0, backgroundImage.getWidth(), backgroundImage.getHeight()); // source bounds
     }
-    else
-    {
-        g.fillAll(juce::Colours::black); // fallback if image fails to load
-    }
-    
+
     g.setColour(juce::Colours::white);           // text colour
     g.setFont(juce::Font(18.0f, juce::Font::bold)); // size and style
 
@@ -166,25 +244,36 @@ void Karplus_Bonus_AudioProcessorEditor::paint(juce::Graphics& g)
     g.drawText("Output", 595 -50, 30, 100, 20, juce::Justification::centred);
 }
 
+void Karplus_Bonus_AudioProcessorEditor::place(juce::Component& component, int x, int y, int width, int height) const
+{
+    component.setBounds((juce::Rectangle<float>(static_cast<float>(x), static_cast<float>(y),
+                                                static_cast<float>(width), static_cast<float>(height)) * scale).toNearestInt());
+}
+
 void Karplus_Bonus_AudioProcessorEditor::resized()
 {
+    scale = static_cast<float>(getWidth()) / designWidth;
+
     // Keyboard
-    processor.keyboardComponent.setBounds(0, 370, getWidth(), 80);
+    place(keyboardComponent, 0, 370, designWidth, 80);
     
     // Source
-    sourceChoice.setBounds(83, 60, 110, 25);
-    decaySlider.setBounds(48, 120, 80, 80);
-    widthSlider.setBounds(148, 120, 80, 80);
-    filterCutoffSlider.setBounds(93, 225, 90, 90);
+    place(sourceChoice, 83, 60, 110, 25);
+    place(decaySlider, 48, 120, 80, 80);
+    place(widthSlider, 148, 120, 80, 80);
+    place(filterCutoffSlider, 93, 225, 90, 90);
 
     // FX
-    tremoloRateSlider.setBounds(291, 68, 80, 80);
-    tremoloDepthSlider.setBounds(406, 68, 80, 80);
-    reverbSizeSlider.setBounds(291, 233, 80, 80);
-    reverbMixSlider.setBounds(406, 233, 80, 80);
+    place(tremoloRateSlider, 291, 68, 80, 80);
+    place(tremoloDepthSlider, 406, 68, 80, 80);
+    place(reverbSizeSlider, 291, 233, 80, 80);
+    place(reverbMixSlider, 406, 233, 80, 80);
 
     // Output
-    gainSlider.setBounds(545, 90, 100, 100);
-    lowFilterCutoffSlider.setBounds(555, 225, 80, 80);
+    place(gainSlider, 545, 90, 100, 100);
+    place(lowFilterCutoffSlider, 555, 225, 80, 80);
 
+#if PLUCK_TELEMETRY
+    place(telemetryView, 10, 347, designWidth - 20, 18);
+#endif
 }
@@ -2,32 +2,24 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "TelemetryView.h"
 
 
+// Knob faces are rendered once per size and display scale, only the pointer is drawn per frame
 class CustomLookAndFeel : public juce::LookAndFeel_V4
 {
 public:
     void drawRotarySlider (juce::Graphics& g, int x, int y, int width, int height,
                            float sliderPosProportional, float rotaryStartAngle,
-                           float rotaryEndAngle, juce::Slider& slider) override
-    {
-        auto radius = juce::jmin(width / 2.0f, height / 2.0f);
-        auto centreX = x + width  * 0.5f;
-        auto centreY = y + height * 0.5f;
-        auto angle = rotaryStartAngle + sliderPosProportional * (rotaryEndAngle - rotaryStartAngle);
-
-        // Background circle
-        g.setColour(juce::Colours::darkgrey);
-        g.fillEllipse(centreX - radius, centreY - radius, radius * 2.0f, radius * 2.0f);
-
-        // Pointer
-        g.setColour(juce::Colours::white);
-        juce::Path p;
-        p.addRectangle(-2.0f, -radius, 4.0f, radius * 0.7f);
-        p.applyTransform(juce::AffineTransform::rotation(angle).translated(centreX, centreY));
-
-        g.fillPath(p);
-    }
+                           float rotaryEndAngle, juce::Slider& slider) override;
+
+private:
+    const juce::Image& getKnobFace(int diameterInPixels);
+    const juce::Path& getPointer(float radius);
+
+    std::map<int, juce::Image> knobFaces;
+    juce::Path pointer;
+    float pointerRadius = -1.0f;
 };
 
 
@@ -39,16 +31,22 @@ public:
 
     void paint(juce::Graphics&) override;
     void resized() override;
-    
-    
+
+    // Layout is designed at this size and scaled to the window
+    static constexpr int designWidth = 700, designHeight = 450;
 
 private:
-    
-    
+    void renderBackground(int width, int height);
+    void place(juce::Component& component, int x, int y, int width, int height) const;
+
     Karplus_Bonus_AudioProcessor& processor;
     
-    // Background Image
+    juce::MidiKeyboardComponent keyboardComponent { processor.keyboardState, juce::MidiKeyboardComponent::horizontalKeyboard };
+
+    // Background Image, decoded on first paint and shared through the image cache. The scaled copy has the section titles baked in.
     juce::Image backgroundImage;
+    juce::Image backgroundCache;
+    float scale = 1.0f;
 
     // Sliders
     juce::Slider gainSlider, decaySlider, widthSlider;
@@ -79,5 +77,9 @@ private:
 
     CustomLookAndFeel customLNF;
 
+#if PLUCK_TELEMETRY
+    TelemetryView telemetryView;
+#endif
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Karplus_Bonus_AudioProcessorEditor)
 };
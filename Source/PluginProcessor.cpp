@@ -1,328 +1,950 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin processor.
-
-  ==============================================================================
-*/
-
-#include "PluginProcessor.h"
-#include "PluginEditor.h"
-
-
-//==============================================================================
-Karplus_Bonus_AudioProcessor::Karplus_Bonus_AudioProcessor()
-#ifndef JucePlugin_PreferredChannelConfigurations
-     : AudioProcessor (BusesProperties()
-                     #if ! JucePlugin_IsMidiEffect
-                      #if ! JucePlugin_IsSynth
-                       .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
-                      #endif
-                       .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
-                     #endif
-                       ),
-       apvts(*this, nullptr, "PARAMETERS", createParameterLayout())
-#endif
-{
-    // No more addParameter(...) here
-}
-
-Karplus_Bonus_AudioProcessor::~Karplus_Bonus_AudioProcessor()
-{
-}
-
-//==============================================================================
-const juce::String Karplus_Bonus_AudioProcessor::getName() const
-{
-    return JucePlugin_Name;
-}
-
-bool Karplus_Bonus_AudioProcessor::acceptsMidi() const
-{
-   #if JucePlugin_WantsMidiInput
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-bool Karplus_Bonus_AudioProcessor::producesMidi() const
-{
-   #if JucePlugin_ProducesMidiOutput
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-bool Karplus_Bonus_AudioProcessor::isMidiEffect() const
-{
-   #if JucePlugin_IsMidiEffect
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-double Karplus_Bonus_AudioProcessor::getTailLengthSeconds() const
-{
-    return 0.0;
-}
-
-int Karplus_Bonus_AudioProcessor::getNumPrograms()
-{
-    return 1;
-}
-
-int Karplus_Bonus_AudioProcessor::getCurrentProgram()
-{
-    return 0;
-}
-
-void Karplus_Bonus_AudioProcessor::setCurrentProgram (int index)
-{
-}
-
-const juce::String Karplus_Bonus_AudioProcessor::getProgramName (int index)
-{
-    return {};
-}
-
-void Karplus_Bonus_AudioProcessor::changeProgramName (int index, const juce::String& newName)
-{
-}
-
-//==============================================================================
-void Karplus_Bonus_AudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
-{
-    const int maxVoices = 16; // Adjust polyphony here
-    voices.clear();
-
-    for (int i = 0; i < maxVoices; ++i)
-    voices.push_back(std::make_unique<KarplusVoice>(sampleRate));
-
-    // Initialize filter (you may control cutoff frequency dynamically)
-    float lowFilterCutoff = apvts.getRawParameterValue("lowFilterCutoff")->load();
-    globalFilterCoefficients = juce::dsp::IIR::Coefficients<float>::makeHighPass(sampleRate, lowFilterCutoff);
-    globalFilter.coefficients = globalFilterCoefficients;
-    globalFilter.reset();
-    
-    reverb.setSampleRate(sampleRate);
-    
-    reverbBuffer.setSize(getTotalNumOutputChannels(), samplesPerBlock);
-    reverbBuffer.clear();
-}
-
-
-void Karplus_Bonus_AudioProcessor::releaseResources()
-{
-    // When playback stops, you can use this as an opportunity to free up any
-    // spare memory, etc.
-}
-
-#ifndef JucePlugin_PreferredChannelConfigurations
-bool Karplus_Bonus_AudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
-{
-  #if JucePlugin_IsMidiEffect
-    juce::ignoreUnused (layouts);
-    return true;
-  #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
-        return false;
-
-    // This checks if the input layout matches the output layout
-   #if ! JucePlugin_IsSynth
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
-        return false;
-   #endif
-
-    return true;
-  #endif
-}
-#endif
-
-void Karplus_Bonus_AudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
-{
-    juce::ScopedNoDenormals noDenormals;
-    
-    keyboardState.processNextMidiBuffer(midiMessages, 0, buffer.getNumSamples(), true);
-    
-    buffer.clear();
-
-    const float sampleRate = (float)getSampleRate();
-
-    // === Retrieve parameters via apvts ===
-    float gain = apvts.getRawParameterValue("gain")->load();
-    int source = static_cast<int>(apvts.getRawParameterValue("source")->load());
-    float decay = apvts.getRawParameterValue("decay")->load();
-    float width = apvts.getRawParameterValue("width")->load();
-    float filterCutoff = apvts.getRawParameterValue("filterCutoff")->load();
-    float lowFilterCutoff = apvts.getRawParameterValue("lowFilterCutoff")->load();
-    float tremoloRate = apvts.getRawParameterValue("tremoloRate")->load();
-    float tremoloDepth = apvts.getRawParameterValue("tremoloDepth")->load();
-    float reverbSize = apvts.getRawParameterValue("reverbSize")->load();
-    float reverbMix = apvts.getRawParameterValue("reverbMix")->load();
-
-    // === Update filter ===
-    *globalFilter.coefficients = *juce::dsp::IIR::Coefficients<float>::makeHighPass(sampleRate, lowFilterCutoff);
-
-    // === Handle MIDI ===
-    for (const auto metadata : midiMessages)
-    {
-        const auto msg = metadata.getMessage();
-
-        if (msg.isNoteOn())
-        {
-            for (auto& voice : voices)
-            {
-                if (!voice->isActive())
-                {
-                    voice->startNote(msg.getNoteNumber(),
-                                     msg.getVelocity() / 127.0f,
-                                     decay,
-                                     width,
-                                     source,
-                                     filterCutoff);
-                    break;
-                }
-            }
-        }
-
-        if (msg.isNoteOff())
-        {
-            for (auto& voice : voices)
-            {
-                voice->stopNote();
-            }
-        }
-    }
-
-    auto* channelDataL = buffer.getWritePointer(0);
-    auto* channelDataR = buffer.getWritePointer(1);
-
-    for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
-    {
-        float mixedSample = 0.0f;
-
-        for (auto& voice : voices)
-            if (voice->isActive())
-                mixedSample += voice->renderNextSample(sampleRate);
-
-        // Apply filter
-        mixedSample = globalFilter.processSample(mixedSample);
-
-        // Apply tremolo
-        float lfo = 1.0f - tremoloDepth * 0.5f * (1.0f + std::sin(2.0f * juce::MathConstants<float>::pi * tremoloPhase));
-        tremoloPhase += tremoloRate / sampleRate;
-        if (tremoloPhase >= 1.0f)
-            tremoloPhase -= 1.0f;
-
-        mixedSample *= lfo;
-
-        channelDataL[sample] = mixedSample;
-        channelDataR[sample] = mixedSample;
-    }
-
-    // === Reverb setup ===
-    reverbParams.roomSize = reverbSize;
-    reverb.setParameters(reverbParams);
-
-    reverbBuffer.makeCopyOf(buffer);
-    reverb.processStereo(reverbBuffer.getWritePointer(0), reverbBuffer.getWritePointer(1), buffer.getNumSamples());
-
-    float dryMix = 1.0f - reverbMix;
-
-    for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
-    {
-        float mixedL = dryMix * channelDataL[sample] + reverbMix * reverbBuffer.getSample(0, sample);
-        float mixedR = dryMix * channelDataR[sample] + reverbMix * reverbBuffer.getSample(1, sample);
-
-        // Final gain applied here
-        channelDataL[sample] = mixedL * gain;
-        channelDataR[sample] = mixedR * gain;
-    }
-}
-
-//==============================================================================
-bool Karplus_Bonus_AudioProcessor::hasEditor() const
-{
-    return true; // (change this to false if you choose to not supply an editor)
-}
-
-juce::AudioProcessorEditor* Karplus_Bonus_AudioProcessor::createEditor()
-{
-    return new Karplus_Bonus_AudioProcessorEditor(*this);
-}
-
-//==============================================================================
-void Karplus_Bonus_AudioProcessor::getStateInformation (juce::MemoryBlock& destData)
-{
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
-}
-
-void Karplus_Bonus_AudioProcessor::setStateInformation (const void* data, int sizeInBytes)
-{
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
-}
-
-//==============================================================================
-// This creates new instances of the plugin..
-juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
-{
-    return new Karplus_Bonus_AudioProcessor();
-}
-
-juce::AudioProcessorValueTreeState::ParameterLayout Karplus_Bonus_AudioProcessor::createParameterLayout()
-{
-    std::vector<std::unique_ptr<juce::RangedAudioParameter>> params;
-
-    params.push_back(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{"gain", 1}, "Gain",
-        juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.5f));
-
-    params.push_back(std::make_unique<juce::AudioParameterChoice>(
-        juce::ParameterID{"source", 1}, "Source",
-        juce::StringArray{ "Sinusoid", "Sawtooth", "Square", "Noise" }, 0));
-
-    params.push_back(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{"decay", 1}, "Decay",
-        juce::NormalisableRange<float>(0.80f, 1.f, 0.01f), 0.97f));
-
-    params.push_back(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{"width", 1}, "Width",
-        juce::NormalisableRange<float>(0.001f, 0.020f, 0.001f), 0.005f));
-
-    params.push_back(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{"filterCutoff", 1}, "Acoustic Attenuator",
-        juce::NormalisableRange<float>(20.0f, 20000.0f, 1.0f, 0.3f), 2000.0f));
-
-    params.push_back(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{"lowFilterCutoff", 1}, "Filter Cutoff",
-        juce::NormalisableRange<float>(20.0f, 500.0f, 1.0f, 0.3f), 20.0f));
-
-    params.push_back(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{"tremoloRate", 1}, "Tremolo Rate",
-        juce::NormalisableRange<float>(0.1f, 20.0f, 0.01f), 2.0f));
-
-    params.push_back(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{"tremoloDepth", 1}, "Tremolo Depth",
-        juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.0f));
-
-    params.push_back(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{"reverbSize", 1}, "Reverb Size",
-        juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.5f));
-
-    params.push_back(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{"reverbMix", 1}, "Reverb Mix",
-        juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.5f));
-
-    return { params.begin(), params.end() };
-}
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin processor.
+
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+
+
+//==============================================================================
+Karplus_Bonus_AudioProcessor::Karplus_Bonus_AudioProcessor()
+#ifndef JucePlugin_PreferredChannelConfigurations
+     : AudioProcessor (BusesProperties()
+                     #if ! JucePlugin_IsMidiEffect
+                      #if ! JucePlugin_IsSynth
+                       .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                      #endif
+                       .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
+                       .withOutput ("Strings 2", juce::AudioChannelSet::stereo(), false)
+                       .withOutput ("Strings 3", juce::AudioChannelSet::stereo(), false)
+                       .withOutput ("Strings 4", juce::AudioChannelSet::stereo(), false)
+                     #endif
+                       ),
+       apvts(*this, nullptr, "PARAMETERS", createParameterLayout()),
+       parameters(apvts)
+#endif
+{
+    // No more addParameter(...) here
+    presets = std::make_unique<PresetBank>();
+    presets->build(apvts);
+    liveBank = presets.get();
+}
+
+Karplus_Bonus_AudioProcessor::~Karplus_Bonus_AudioProcessor()
+{
+    cancelPendingUpdate();
+}
+
+//==============================================================================
+const juce::String Karplus_Bonus_AudioProcessor::getName() const
+{
+    return JucePlugin_Name;
+}
+
+bool Karplus_Bonus_AudioProcessor::acceptsMidi() const
+{
+   #if JucePlugin_WantsMidiInput
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+bool Karplus_Bonus_AudioProcessor::producesMidi() const
+{
+   #if JucePlugin_ProducesMidiOutput
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+bool Karplus_Bonus_AudioProcessor::isMidiEffect() const
+{
+   #if JucePlugin_IsMidiEffect
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+double Karplus_Bonus_AudioProcessor::getTailLengthSeconds() const
+{
+    const auto p = parameters.snapshot();
+    const double sampleRate = getSampleRate() > 0.0 ? getSampleRate() : 44100.0;
+
+    // The lowest string rings longest: its loop loses decay * |H(f0)| per period,
+    // and after note-off the release damping caps that
+    const float lowestNote = static_cast<float>(DelayLinePool::lowestNoteHz);
+    const float loopGain = p.decay * BiquadCoefficients::lowPass(sampleRate, p.filterCutoff).getMagnitude(sampleRate, lowestNote);
+    const float lossPerPeriod = -20.0f * std::log10(juce::jlimit(1.0e-6f, 0.999999f, loopGain));
+    const float silenceDecibels = -10.0f * std::log10(KarplusVoice::silenceThreshold);
+    const float ringSeconds = silenceDecibels / lossPerPeriod / lowestNote;
+    const float releaseSeconds = KarplusVoice::releaseTime * silenceDecibels / 60.0f;
+    const float stringSeconds = juce::jmin(ringSeconds, releaseSeconds);
+
+    const float sympatheticSeconds = p.sympathetic != SympatheticBank::off && p.sympatheticLevel > 0.0f ? 2.0f * SympatheticBank::sustainSeconds : 0.0f;
+    const float bodySeconds = p.bodyMix > 0.0f ? BodyResonator::getImpulseSeconds(p.body) : 0.0f;
+    const float reverbSeconds = p.reverbMix > 0.0f ? FdnReverb::getTailSeconds(p.reverbSize) : 0.0f;
+    return static_cast<double>(juce::jmax(stringSeconds, sympatheticSeconds) + bodySeconds + reverbSeconds);
+}
+
+int Karplus_Bonus_AudioProcessor::getNumPrograms()
+{
+    return presets->size();
+}
+
+int Karplus_Bonus_AudioProcessor::getCurrentProgram()
+{
+    return currentProgram.load();
+}
+
+void Karplus_Bonus_AudioProcessor::setCurrentProgram (int index)
+{
+    if (! juce::isPositiveAndBelow(index, presets->size()))
+        return;
+
+    // The audio thread picks up the whole preset at once, the parameters follow one by one
+    const auto* preset = &(*presets)[index];
+    currentProgram = index;
+    activePreset.store(preset);
+    writePresetToParameters(*preset);
+    activePreset.compare_exchange_strong(preset, nullptr);
+}
+
+const juce::String Karplus_Bonus_AudioProcessor::getProgramName (int index)
+{
+    return juce::isPositiveAndBelow(index, presets->size()) ? (*presets)[index].name : juce::String();
+}
+
+void Karplus_Bonus_AudioProcessor::changeProgramName (int index, const juce::String& newName)
+{
+}
+
+//==============================================================================
+void Karplus_Bonus_AudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
+{
+    // A voice and a delay line for the highest polyphony, so it can change live. Lines of voices that never
+    // play are never touched, see DelayLinePool.
+    const auto p = parameters.snapshot();
+    const int maxVoices = VoiceAllocator::maxPolyphony + VoiceAllocator::stealHeadroom;
+    const int delayLineLength = DelayLinePool::getLineLength(sampleRate);
+
+    // Silence every voice, which also hands back the note cache entries they replay before any voice is rebuilt
+    for (auto& voice : voices)
+        voice->deactivate();
+
+    // Hosts re-prepare at the same rate on transport and latency changes, keep the voices then
+    if (sampleRate != preparedSampleRate || p.loopStorage != delayLines.getFormat() || static_cast<int>(voices.size()) != maxVoices)
+    {
+        voices.clear();
+        delayLines.prepare(maxVoices, delayLineLength, p.loopStorage);
+
+        for (int i = 0; i < maxVoices; ++i)
+        {
+            if (p.loopStorage == DelayLinePool::half)
+                voices.push_back(std::make_unique<KarplusVoice>(sampleRate, delayLines.getHalfLine(i), delayLineLength));
+            else
+                voices.push_back(std::make_unique<KarplusVoice>(sampleRate, delayLines.getLine(i), delayLineLength));
+        }
+
+        preparedSampleRate = sampleRate;
+    }
+
+    voiceAllocator.prepare(voices);
+    voiceAllocator.setPolyphony(p.polyphony);
+    noteCache.prepare(sampleRate, delayLineLength);
+    // At 88.2 kHz and above no string needs the full host rate, only High quality still runs them there
+    baseRateIndex = 0;
+    while (baseRateIndex < numRates - 1 && sampleRate / (2 << baseRateIndex) >= 44100.0)
+        ++baseRateIndex;
+
+    ratePhase = 0;
+    presets->prepare(sampleRate, numRates);
+    primedPreset = nullptr;
+
+    for (int rate = 0; rate < numRates; ++rate)
+    {
+        const double rateSampleRate = sampleRate / (1 << rate);
+        tuningTables[rate] = sharedTables->getTuningTable(rateSampleRate, delayLineLength);
+        feedbackCoefficients[rate].prepare(rateSampleRate);
+    }
+
+    // Pick the output path for the current bus layout
+    const int mainChannels = getMainBusNumOutputChannels();
+    mainOutputPath = mainChannels == 1 ? &Karplus_Bonus_AudioProcessor::processMainOutput<1>
+                                       : &Karplus_Bonus_AudioProcessor::processMainOutput<2>;
+    multiOut = false;
+
+    for (int group = 0; group < maxOutputGroups; ++group)
+    {
+        const auto* bus = getBus(false, group);
+        const bool routed = group > 0 && bus != nullptr && bus->isEnabled();
+        groupTarget[group] = routed ? group : 0;
+        multiOut = multiOut || routed;
+    }
+
+    const int numGroups = multiOut ? maxOutputGroups : 1;
+    preparedBlockSize = samplesPerBlock;
+    voiceMixBuffer.setSize(numGroups, samplesPerBlock);
+
+    for (auto& bucket : voiceBuckets)
+        bucket.reserve(voices.size());
+
+    for (auto& bucket : tracedBuckets)
+        bucket.reserve(voices.size());
+
+    for (int rate = 0; rate < numRates; ++rate)
+    {
+        rateMix[rate].setSize(numGroups, samplesPerBlock / (1 << rate) + 1);
+
+        for (auto& upsampler : upsamplers[rate])
+            upsampler.prepare(1 << rate);
+    }
+
+    // Every rate reaches the mix through the same whole-sample upsampler delay, unless all voices run at the host rate
+    const int preparedQuality = isNonRealtime() ? high : p.quality;
+    ratesAligned = getEffectiveVoiceRate(preparedQuality, p.voiceRate) != fullRate || getLowestRateIndex(preparedQuality) > 0;
+    setLatencySamples(ratesAligned ? PolyphaseUpsampler::latencySamples : 0);
+
+    // Initialize filters, coefficients are designed on first use and whenever a cutoff changes
+    globalFilterCoefficients.prepare(sampleRate);
+    globalFilter.reset();
+    
+    // Widest kernels this CPU runs, picked once per session
+    kernels = &DspKernels::get(DspKernels::detectIsa());
+    voiceBank.setKernels(*kernels);
+
+    // Worker threads are spawned here, never on the audio thread
+    voiceRenderPool.prepare(p.renderThreads, samplesPerBlock, numRates * maxOutputGroups, sampleRate);
+
+    // Smoothed controls start from the current parameter values
+    lowFilterCutoff.reset(sampleRate, 0.05);
+    lowFilterCutoff.setCurrentAndTargetValue(p.lowFilterCutoff);
+    tremolo.prepare(sampleRate, samplesPerBlock, p.tremoloRate, p.tremoloDepth);
+    reverbMix.prepare(sampleRate, samplesPerBlock, 0.02, p.reverbMix);
+    bodyMix.prepare(sampleRate, samplesPerBlock, 0.02, p.bodyMix);
+    gain.prepare(sampleRate, samplesPerBlock, 0.02, p.gain);
+
+    sympatheticStrings.prepare(sampleRate);
+
+    // Body impulses for the new rate, designed by the first instance to ask. The tail thread starts here.
+    bodyResonator.prepare(sharedTables->getBodyImpulses(sampleRate));
+    bodyResonator.setBody(p.body);
+
+    reverb.prepare(sampleRate);
+    telemetry.prepare(sampleRate);
+    reverb.setSize(p.reverbSize);
+}
+
+
+void Karplus_Bonus_AudioProcessor::releaseResources()
+{
+    // When playback stops, you can use this as an opportunity to free up any
+    // spare memory, etc. Idle render workers only sleep, they are kept for the next prepareToPlay.
+    bodyResonator.release();
+    noteCache.release();
+}
+
+#ifndef JucePlugin_PreferredChannelConfigurations
+bool Karplus_Bonus_AudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
+{
+  #if JucePlugin_IsMidiEffect
+    juce::ignoreUnused (layouts);
+    return true;
+  #else
+    // This is the place where you check if the layout is supported.
+    // In this template code we only support mono or stereo.
+    // Some plugin hosts, such as certain GarageBand versions, will only
+    // load plugins that support stereo bus layouts.
+    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
+     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+        return false;
+
+    // Aux string buses are optional, mono or stereo
+    for (int bus = 1; bus < layouts.outputBuses.size(); ++bus)
+    {
+        const auto set = layouts.getChannelSet(false, bus);
+        if (! set.isDisabled() && set != juce::AudioChannelSet::mono() && set != juce::AudioChannelSet::stereo())
+            return false;
+    }
+
+    // This checks if the input layout matches the output layout
+   #if ! JucePlugin_IsSynth
+    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+        return false;
+   #endif
+
+    return true;
+  #endif
+}
+#endif
+
+void Karplus_Bonus_AudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    // Once over the whole host block, outside the allocation guard: merging the on-screen keyboard's notes
+    // takes the keyboard state's lock and can grow the host's buffer
+    keyboardState.processNextMidiBuffer(midiMessages, 0, buffer.getNumSamples(), true);
+
+    // Every buffer is sized for the block prepareToPlay announced, so a longer one is never allocated for here
+    if (preparedBlockSize <= 0 || buffer.getNumSamples() <= preparedBlockSize)
+    {
+        processChunk(buffer, midiMessages, 0);
+        return;
+    }
+
+    for (int start = 0; start < buffer.getNumSamples(); start += preparedBlockSize)
+    {
+        const int numSamples = juce::jmin(preparedBlockSize, buffer.getNumSamples() - start);
+        juce::AudioBuffer<float> chunk(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), start, numSamples);
+        processChunk(chunk, midiMessages, start);
+    }
+}
+
+void Karplus_Bonus_AudioProcessor::processChunk(juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& midiMessages, int midiStart)
+{
+    juce::ScopedNoDenormals noDenormals;
+    ScopedAudioThreadGuard audioThreadGuard;
+    telemetry.beginBlock(buffer.getNumSamples());
+
+    // This block's events, at host positions from midiStart on
+    const auto firstEvent = midiMessages.findNextSamplePosition(midiStart);
+    const auto lastEvent = midiMessages.findNextSamplePosition(midiStart + buffer.getNumSamples());
+    
+    buffer.clear();
+
+    // === Idle: no strings sounding or starting, and the body and reverb tails have died away ===
+    if (voiceAllocator.getActiveVoices().empty() && sympatheticStrings.isAsleep() && bodyResonator.isQuiet() && reverb.isAsleep()
+         && ! containsNoteOnOrProgramChange(firstEvent, lastEvent))
+    {
+        globalFilter.reset();
+
+        // Whatever is still in the upsamplers is below the silence threshold, don't let it out at the next note
+        for (auto& rateUpsamplers : upsamplers)
+            for (auto& upsampler : rateUpsamplers)
+                upsampler.reset();
+
+        snapControls(snapshotParameters(holdBank()));
+        heldBank.store(nullptr);
+
+        telemetry.endBlock(0, voiceAllocator.getDroppedNotes(), bodyResonator.getTailOverruns());
+        return;
+    }
+
+    // === Retrieve parameters ===
+    const auto& bank = holdBank();
+    auto p = snapshotParameters(bank);
+
+    // === Quality tier, a host's offline bounce always gets the best one ===
+    const int quality = isNonRealtime() ? high : p.quality;
+    const int voiceRate = getEffectiveVoiceRate(quality, p.voiceRate);
+    const int lowestRate = getLowestRateIndex(quality);
+    exciterBank.setOversampling(quality == high);
+    tremolo.setControlInterval(quality == eco ? 4 * ControlRamp::defaultControlInterval : ControlRamp::defaultControlInterval);
+    reverb.setEconomy(quality == eco);
+
+    // The message thread reports the new latency. The full-rate delay starts from silence when it comes back in.
+    const bool alignRates = voiceRate != fullRate || lowestRate > 0;
+
+    if (alignRates != ratesAligned.load())
+    {
+        for (auto& upsampler : upsamplers[0])
+            upsampler.reset();
+
+        ratesAligned = alignRates;
+        triggerAsyncUpdate();
+    }
+
+    // === Handle MIDI and render voices ===
+    voiceAllocator.setPolyphony(p.polyphony);
+    voiceAllocator.setStealMode(p.voiceStealing);
+
+    const int numSamples = buffer.getNumSamples();
+    voiceMixBuffer.setSize(voiceMixBuffer.getNumChannels(), numSamples, false, false, true);
+    voiceMixBuffer.clear();
+    auto* voiceMix = voiceMixBuffer.getWritePointer(0);
+
+    for (int rate = 0; rate < numRates; ++rate)
+    {
+        rateMix[rate].setSize(voiceMixBuffer.getNumChannels(), toRateSamples(numSamples, rate), false, false, true);
+        rateMix[rate].clear();
+    }
+
+    // Render up to each event that changes the voices, so notes start and stop on their exact sample.
+    // Controllers, pitch bend and aftertouch don't reach the strings, so they don't split the block.
+    int renderedSamples = 0;
+
+    for (auto event = firstEvent; event != lastEvent; ++event)
+    {
+        const auto metadata = *event;
+        const auto msg = metadata.getMessage();
+
+        if (! (msg.isNoteOnOrOff() || msg.isProgramChange() || msg.isAllNotesOff() || msg.isAllSoundOff()))
+            continue;
+
+        const int eventPosition = juce::jlimit(renderedSamples, numSamples, metadata.samplePosition - midiStart);
+        renderVoices(renderedSamples, eventPosition - renderedSamples);
+        renderedSamples = eventPosition;
+
+        const TelemetryRecorder::ScopedStage midiTime(telemetry, BlockMetrics::midi);
+
+        if (msg.isNoteOn())
+        {
+            if (auto* voice = voiceAllocator.noteOn(msg.getNoteNumber()))
+            {
+                const int rate = chooseRateIndex(msg.getNoteNumber(), p.filterCutoff, voiceRate, lowestRate);
+                const float loopCutoff = quality == eco ? TuningTable::averageFilter : p.filterCutoff;
+                const auto loopFilter = quality == eco ? BiquadCoefficients::average() : feedbackCoefficients[rate].get(p.filterCutoff);
+                voice->setOutputGroup((msg.getChannel() - 1) % maxOutputGroups);
+                voice->setRateDivision(1 << rate);
+                voice->startNote(msg.getNoteNumber(),
+                                 msg.getVelocity() / 127.0f,
+                                 p.decay,
+                                 p.width,
+                                 p.source,
+                                 loopFilter,
+                                 tuningTables[rate]->get(msg.getNoteNumber(), p.tuning, loopCutoff),
+                                 exciterBank);
+
+                if (p.noteCache)
+                    noteCache.start(*voice);
+            }
+        }
+
+        if (msg.isNoteOff())
+            voiceAllocator.noteOff(msg.getNoteNumber());
+
+        if (msg.isProgramChange() && juce::isPositiveAndBelow(msg.getProgramChangeNumber(), bank.size()))
+        {
+            const auto& preset = bank[msg.getProgramChangeNumber()];
+            currentProgram = msg.getProgramChangeNumber();
+            activePreset.store(&preset);
+            applyPreset(preset, p);
+            triggerAsyncUpdate();
+        }
+
+        if (msg.isAllNotesOff() || msg.isAllSoundOff())
+            voiceAllocator.allNotesOff();
+    }
+
+    renderVoices(renderedSamples, numSamples - renderedSamples);
+
+    // Silence is judged on the whole block, not on the stretches between events
+    voiceAllocator.removeFinishedVoices();
+
+    // Bring the decimated voices back to the host rate, and delay the full-rate ones to match if there can be any
+    {
+        const TelemetryRecorder::ScopedStage upsampleTime(telemetry, BlockMetrics::voices);
+
+        for (int rate = 0; rate < numRates; ++rate)
+            for (int group = 0; group < voiceMixBuffer.getNumChannels(); ++group)
+                if (rate == 0 && ! alignRates)
+                    juce::FloatVectorOperations::add(voiceMixBuffer.getWritePointer(group), rateMix[0].getReadPointer(group), numSamples);
+                else
+                    upsamplers[rate][group].process(rateMix[rate].getReadPointer(group), voiceMixBuffer.getWritePointer(group),
+                                                    numSamples, ratePhase & ((1 << rate) - 1));
+    }
+
+    ratePhase = (ratePhase + numSamples) & ((1 << (numRates - 1)) - 1);
+
+    // === Sympathetic strings, driven by the voice mix and tuned like the voices ===
+    {
+        const TelemetryRecorder::ScopedStage resonanceTime(telemetry, BlockMetrics::resonance);
+        sympatheticStrings.setStrings(p.sympathetic, *tuningTables[0], p.tuning, quality == eco ? TuningTable::averageFilter : p.filterCutoff);
+        sympatheticStrings.setSoundingNotes(voiceAllocator.getActiveVoices());
+        sympatheticStrings.process(voiceMix, p.sympatheticLevel, numSamples);
+    }
+
+    // === Control rate ramps ===
+    auto stageStart = telemetry.now();
+    lowFilterCutoff.setTargetValue(p.lowFilterCutoff);
+    tremolo.setParameters(p.tremoloRate, p.tremoloDepth);
+    reverbMix.setTargetValue(p.reverbMix);
+    bodyMix.setTargetValue(p.bodyMix);
+    gain.setTargetValue(p.gain);
+
+    const float* tremoloGain = tremolo.process(numSamples);
+    const float* wetMix = reverbMix.process(numSamples);
+    const float* bodyWetMix = bodyMix.process(numSamples);
+    const float* outputGain = gain.process(numSamples);
+    telemetry.addSince(BlockMetrics::filters, stageStart);
+
+    // === Instrument body, convolved into the voice mix ===
+    {
+        const TelemetryRecorder::ScopedStage bodyTime(telemetry, BlockMetrics::body);
+        bodyResonator.setNonRealtime(isNonRealtime());
+        bodyResonator.setBody(p.body);
+        bodyResonator.process(voiceMix, bodyWetMix, numSamples);
+    }
+
+    stageStart = telemetry.now();
+
+    // === Apply filter, coefficients follow the smoothed cutoff every control interval ===
+    for (int start = 0; start < numSamples; start += ControlRamp::defaultControlInterval)
+    {
+        const int end = juce::jmin(numSamples, start + ControlRamp::defaultControlInterval);
+        const auto& highPass = globalFilterCoefficients.get(lowFilterCutoff.skip(end - start));
+
+        for (int sample = start; sample < end; ++sample)
+            voiceMix[sample] = globalFilter.processSample(highPass, voiceMix[sample]);
+    }
+
+    // === Apply tremolo ===
+    kernels->multiply(voiceMix, tremoloGain, numSamples);
+
+    telemetry.addSince(BlockMetrics::filters, stageStart);
+
+    // === Reverb, dry/wet and final gain on the main bus ===
+    stageStart = telemetry.now();
+    reverb.setSize(p.reverbSize);
+
+    auto mainBus = getBusBuffer(buffer, false, 0);
+    (this->*mainOutputPath)(mainBus, voiceMix, wetMix, outputGain, numSamples);
+    telemetry.addSince(BlockMetrics::reverb, stageStart);
+
+    // === Routed voice groups go out dry ===
+    stageStart = telemetry.now();
+
+    if (multiOut)
+        for (int group = 1; group < maxOutputGroups; ++group)
+            if (groupTarget[group] == group)
+                writeOutputGroup(group, buffer, outputGain, numSamples);
+
+    telemetry.addSince(BlockMetrics::output, stageStart);
+    telemetry.endBlock(getNumActiveVoices(), voiceAllocator.getDroppedNotes(), bodyResonator.getTailOverruns());
+
+    // The message thread may free the bank from here on
+    heldBank.store(nullptr);
+}
+
+template <int numChannels>
+void Karplus_Bonus_AudioProcessor::processMainOutput(juce::AudioBuffer<float>& mainBus, const float* voiceMix, const float* wetMix, const float* outputGain, int numSamples)
+{
+    // The reverb reads the voice mix and writes the finished output, dry/wet and gain included
+    auto* left = mainBus.getWritePointer(0);
+    auto* right = numChannels == 2 ? mainBus.getWritePointer(1) : nullptr;
+    reverb.process(voiceMix, left, right, wetMix, outputGain, numSamples);
+}
+
+void Karplus_Bonus_AudioProcessor::writeOutputGroup(int group, juce::AudioBuffer<float>& buffer, const float* outputGain, int numSamples)
+{
+    auto bus = getBusBuffer(buffer, false, group);
+    const auto* groupMix = voiceMixBuffer.getReadPointer(group);
+
+    for (int channel = 0; channel < bus.getNumChannels(); ++channel)
+        juce::FloatVectorOperations::multiply(bus.getWritePointer(channel), groupMix, outputGain, numSamples);
+}
+
+int Karplus_Bonus_AudioProcessor::chooseRateIndex(int midiNote, float filterCutoff, int voiceRate, int lowestRate) const
+{
+    // Full only turns off the per-note choice, at 88.2 kHz and above the strings still run at the base rate
+    if (voiceRate == fullRate)
+        return lowestRate;
+
+    // The loop low-pass removes everything well above its cutoff within a few periods,
+    // so a rate is used when the upsampler passband covers a margin above the cutoff and the fundamental
+    constexpr float bandwidthMargin = 4.0f;
+    const float bandwidth = bandwidthMargin * juce::jmax(filterCutoff, static_cast<float>(juce::MidiMessage::getMidiNoteInHertz(midiNote)));
+
+    for (int rate = numRates - 1; rate > lowestRate; --rate)
+        if (0.45 * getSampleRate() / (1 << rate) >= bandwidth)
+            return rate;
+
+    return lowestRate;
+}
+
+int Karplus_Bonus_AudioProcessor::getEffectiveVoiceRate(int quality, int voiceRate)
+{
+    return quality == eco ? adaptiveRate : quality == high ? fullRate : voiceRate;
+}
+
+int Karplus_Bonus_AudioProcessor::getLowestRateIndex(int quality) const
+{
+    return quality == high ? 0 : baseRateIndex;
+}
+
+int Karplus_Bonus_AudioProcessor::toRateSamples(int hostSample, int rateIndex) const
+{
+    // Samples of the decimated rate fall on host samples whose absolute position is a multiple of the division
+    const int division = 1 << rateIndex;
+    return (ratePhase + hostSample + division - 1) / division - (ratePhase + division - 1) / division;
+}
+
+bool Karplus_Bonus_AudioProcessor::containsNoteOnOrProgramChange(juce::MidiBufferIterator first, juce::MidiBufferIterator last)
+{
+    for (auto event = first; event != last; ++event)
+    {
+        const auto msg = (*event).getMessage();
+        if (msg.isNoteOn() || msg.isProgramChange())
+            return true;
+    }
+
+    return false;
+}
+
+void Karplus_Bonus_AudioProcessor::applyPreset(const Preset& preset, ParameterSnapshot& p)
+{
+    p.applySound(preset.sound);
+
+    // Loop filters were designed when the bank was prepared
+    if (&preset != primedPreset && preset.feedbackCoefficients.size() == static_cast<size_t>(numRates))
+    {
+        for (int rate = 0; rate < numRates; ++rate)
+            feedbackCoefficients[rate].prime(preset.sound.filterCutoff, preset.feedbackCoefficients[static_cast<size_t>(rate)]);
+
+        primedPreset = &preset;
+    }
+}
+
+ParameterSnapshot Karplus_Bonus_AudioProcessor::snapshotParameters(const PresetBank& bank)
+{
+    auto p = parameters.snapshot();
+    const auto* selectedPreset = activePreset.load();
+
+    // A program picked from a bank that has since been replaced is left to the message thread
+    if (selectedPreset != nullptr && bank.contains(selectedPreset))
+        applyPreset(*selectedPreset, p);
+
+    return p;
+}
+
+void Karplus_Bonus_AudioProcessor::writePresetToParameters(const Preset& preset)
+{
+    for (auto& value : preset.values)
+        if (auto* parameter = apvts.getParameter(value.parameterID))
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value.value));
+}
+
+void Karplus_Bonus_AudioProcessor::handleAsyncUpdate()
+{
+    // A program change arrived on the audio thread, bring the parameters in line with it and let the host know
+    if (const auto* preset = activePreset.load())
+    {
+        writePresetToParameters(*preset);
+        activePreset.compare_exchange_strong(preset, nullptr);
+        updateHostDisplay(juce::AudioProcessorListener::ChangeDetails().withProgramChanged(true));
+    }
+
+    // The voice rate or quality tier decided whether the voices need lining up
+    setLatencySamples(ratesAligned.load() ? PolyphaseUpsampler::latencySamples : 0);
+}
+
+const PresetBank& Karplus_Bonus_AudioProcessor::holdBank()
+{
+    // Marked before it is read, and read again in case a new bank was published in between
+    const PresetBank* bank = nullptr;
+
+    do
+    {
+        bank = liveBank.load();
+        heldBank.store(bank);
+    }
+    while (bank != liveBank.load());
+
+    // Pointers into an earlier bank mean nothing now
+    if (bank != lastHeldBank)
+    {
+        primedPreset = nullptr;
+        lastHeldBank = bank;
+    }
+
+    return *bank;
+}
+
+void Karplus_Bonus_AudioProcessor::publishBank(std::unique_ptr<PresetBank> bank)
+{
+    // Complete and lay out the presets, and design their loop filters if the rate is already known
+    bank->build(apvts);
+
+    if (preparedSampleRate > 0.0)
+        bank->prepare(preparedSampleRate, numRates);
+
+    const std::unique_ptr<PresetBank> previous = std::move(presets);
+    presets = std::move(bank);
+    liveBank.store(presets.get());
+
+    // A block that picked up the old bank before the swap is done within one block
+    while (heldBank.load() == previous.get())
+        juce::Thread::sleep(1);
+
+    // A MIDI program change taken from the old bank is written out while that bank still exists
+    const auto* preset = activePreset.load();
+
+    if (preset != nullptr && previous->contains(preset))
+    {
+        writePresetToParameters(*preset);
+        activePreset.compare_exchange_strong(preset, nullptr);
+    }
+
+    currentProgram = juce::jlimit(0, presets->size() - 1, currentProgram.load());
+    updateHostDisplay(juce::AudioProcessorListener::ChangeDetails().withProgramChanged(true));
+}
+
+bool Karplus_Bonus_AudioProcessor::loadBank(juce::InputStream& stream)
+{
+    auto bank = std::make_unique<PresetBank>();
+
+    if (! bank->readFrom(stream, apvts))
+        return false;
+
+    publishBank(std::move(bank));
+    loadedBank = true;
+    return true;
+}
+
+bool Karplus_Bonus_AudioProcessor::loadBank(const juce::ValueTree& tree)
+{
+    auto bank = std::make_unique<PresetBank>();
+
+    if (! bank->fromValueTree(tree))
+        return false;
+
+    publishBank(std::move(bank));
+    loadedBank = true;
+    return true;
+}
+
+void Karplus_Bonus_AudioProcessor::snapControls(const ParameterSnapshot& p)
+{
+    lowFilterCutoff.setCurrentAndTargetValue(p.lowFilterCutoff);
+    tremolo.setCurrentParameters(p.tremoloRate, p.tremoloDepth);
+    reverbMix.setCurrentAndTargetValue(p.reverbMix);
+    bodyMix.setCurrentAndTargetValue(p.bodyMix);
+    gain.setCurrentAndTargetValue(p.gain);
+}
+
+void Karplus_Bonus_AudioProcessor::renderVoices(int startSample, int numSamples)
+{
+    if (numSamples <= 0)
+        return;
+
+    const TelemetryRecorder::ScopedStage renderTime(telemetry, BlockMetrics::voices);
+
+    // Split the active voices by rate and by the bus they are routed to, capacity is reserved in prepareToPlay
+    for (auto& bucket : voiceBuckets)
+        bucket.clear();
+
+    for (auto& bucket : tracedBuckets)
+        bucket.clear();
+
+    for (auto* voice : voiceAllocator.getActiveVoices())
+    {
+        const int rate = voice->getRateDivision() == 4 ? 2 : voice->getRateDivision() - 1;
+        const int group = multiOut ? groupTarget[voice->getOutputGroup()] : 0;
+        auto& buckets = voice->isPlayingTrace() ? tracedBuckets : voiceBuckets;
+        buckets[static_cast<size_t>(rate * maxOutputGroups + group)].push_back(voice);
+    }
+
+    // Every rate and bus goes to the render threads as one job set, so they are woken and joined once
+    voiceRenderPool.clear();
+
+    for (int rate = 0; rate < numRates; ++rate)
+    {
+        // The same stretch of the block, counted in samples of this rate
+        const int first = toRateSamples(startSample, rate);
+        const int count = toRateSamples(startSample + numSamples, rate) - first;
+
+        for (int group = 0; group < rateMix[rate].getNumChannels() && count > 0; ++group)
+            voiceRenderPool.add(voiceBuckets[static_cast<size_t>(rate * maxOutputGroups + group)],
+                                rateMix[rate].getWritePointer(group) + first, count);
+    }
+
+    voiceRenderPool.render(voiceBank);
+
+    // Replayed voices only copy samples, the audio thread does those itself
+    for (int rate = 0; rate < numRates; ++rate)
+    {
+        const int first = toRateSamples(startSample, rate);
+        const int count = toRateSamples(startSample + numSamples, rate) - first;
+
+        for (int group = 0; group < rateMix[rate].getNumChannels() && count > 0; ++group)
+            for (auto* voice : tracedBuckets[static_cast<size_t>(rate * maxOutputGroups + group)])
+                voice->renderBlock(rateMix[rate].getWritePointer(group) + first, count);
+    }
+}
+
+//==============================================================================
+bool Karplus_Bonus_AudioProcessor::hasEditor() const
+{
+    return true; // (change this to false if you choose to not supply an editor)
+}
+
+juce::AudioProcessorEditor* Karplus_Bonus_AudioProcessor::createEditor()
+{
+    return new Karplus_Bonus_AudioProcessorEditor(*this);
+}
+
+//==============================================================================
+void Karplus_Bonus_AudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    // A host without a running message loop still saves the program a MIDI program change picked
+    if (juce::MessageManager::existsAndIsCurrentThread())
+        handleUpdateNowIfNeeded();
+
+    // Binary: tag, version, program, the plain value of every parameter, then the bank if one was loaded
+    juce::MemoryOutputStream stream(destData, false);
+    stream.writeInt(stateTag);
+    stream.writeCompressedInt(stateVersion);
+    stream.writeCompressedInt(currentProgram.load());
+
+    std::vector<ParameterValue> values;
+    for (auto* parameter : getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+            values.push_back({ ranged->paramID, ranged->convertFrom0to1(ranged->getValue()) });
+
+    PresetBank::writeValues(stream, values);
+
+    // The factory bank is built in, so it isn't stored
+    stream.writeBool(loadedBank);
+
+    if (loadedBank)
+        presets->writeTo(stream);
+}
+
+void Karplus_Bonus_AudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    juce::MemoryInputStream stream(data, static_cast<size_t>(sizeInBytes), false);
+    const int tag = stream.readInt();
+    const int version = stream.readCompressedInt();
+
+    if (tag == stateTag && version <= stateVersion)
+    {
+        const int program = stream.readCompressedInt();
+
+        // Applied as one new state, so the host isn't sent a change for every parameter
+        auto state = apvts.copyState();
+
+        for (auto& value : PresetBank::readValues(stream, apvts))
+        {
+            auto parameter = state.getChildWithProperty("id", value.parameterID);
+
+            if (parameter.isValid())
+                parameter.setProperty("value", value.value, nullptr);
+        }
+
+        // A session without a stored bank played the factory presets
+        if (version >= 2 && stream.readBool())
+        {
+            loadBank(stream);
+        }
+        else if (loadedBank)
+        {
+            publishBank(std::make_unique<PresetBank>());
+            loadedBank = false;
+        }
+
+        currentProgram = juce::jlimit(0, presets->size() - 1, program);
+        apvts.replaceState(state);
+        return;
+    }
+
+    // State written as APVTS XML
+    if (auto xml = getXmlFromBinary(data, sizeInBytes))
+        if (xml->hasTagName(apvts.state.getType()))
+            apvts.replaceState(juce::ValueTree::fromXml(*xml));
+}
+
+//==============================================================================
+// This creates new instances of the plugin..
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+    return new Karplus_Bonus_AudioProcessor();
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout Karplus_Bonus_AudioProcessor::createParameterLayout()
+{
+    std::vector<std::unique_ptr<juce::RangedAudioParameter>> params;
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{"gain", 1}, "Gain",
+        juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.5f));
+
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{"source", 1}, "Source",
+        juce::StringArray{ "Sinusoid", "Sawtooth", "Square", "Noise" }, 0));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{"decay", 1}, "Decay",
+        juce::NormalisableRange<float>(0.80f, 1.f, 0.01f), 0.97f));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{"width", 1}, "Width",
+        juce::NormalisableRange<float>(0.001f, 0.020f, 0.001f), 0.005f));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{"filterCutoff", 1}, "Acoustic Attenuator",
+        juce::NormalisableRange<float>(20.0f, 20000.0f, 1.0f, 0.3f), 2000.0f));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{"lowFilterCutoff", 1}, "Filter Cutoff",
+        juce::NormalisableRange<float>(20.0f, 500.0f, 1.0f, 0.3f), 20.0f));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{"tremoloRate", 1}, "Tremolo Rate",
+        juce::NormalisableRange<float>(0.1f, 20.0f, 0.01f), 2.0f));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{"tremoloDepth", 1}, "Tremolo Depth",
+        juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.0f));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{"reverbSize", 1}, "Reverb Size",
+        juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.5f));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{"reverbMix", 1}, "Reverb Mix",
+        juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.5f));
+
+    // Added after the first release: keep new parameters below the originals, so host parameter indices stay put
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{"tuning", 1}, "Tuning",
+        juce::StringArray{ "Allpass", "Lagrange", "Truncated" }, 0));
+
+    params.push_back(std::make_unique<juce::AudioParameterInt>(
+        juce::ParameterID{"polyphony", 1}, "Polyphony", 1, VoiceAllocator::maxPolyphony, 16));
+
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{"voiceStealing", 1}, "Voice Stealing",
+        juce::StringArray{ "Oldest", "Quietest" }, 0));
+
+    params.push_back(std::make_unique<juce::AudioParameterInt>(
+        juce::ParameterID{"renderThreads", 1}, "Render Threads", 1, 16, 1));
+
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{"voiceRate", 1}, "Voice Rate",
+        juce::StringArray{ "Full", "Adaptive" }, fullRate));
+
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{"body", 1}, "Body",
+        BodyResonator::getBodyNames(), BodyResonator::none));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{"bodyMix", 1}, "Body Mix",
+        juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.7f));
+
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{"sympathetic", 1}, "Sympathetic Strings",
+        SympatheticBank::getModeNames(), SympatheticBank::off));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{"sympatheticLevel", 1}, "Sympathetic Level",
+        juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.3f));
+
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{"quality", 1}, "Quality",
+        getQualityNames(), standard));
+
+    params.push_back(std::make_unique<juce::AudioParameterBool>(
+        juce::ParameterID{"noteCache", 1}, "Note Cache", false));
+
+    // Read in prepareToPlay, like the render thread count
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{"loopStorage", 1}, "Loop Storage",
+        juce::StringArray{ "Float", "Half" }, DelayLinePool::full));
+
+    return { params.begin(), params.end() };
+}
@@ -1,103 +1,240 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin processor.
-
-  ==============================================================================
-*/
-
-#pragma once
-
-#include <JuceHeader.h>
-#include <juce_dsp/juce_dsp.h>
-#include "KarplusVoice.h"
-
-//==============================================================================
-/**
-*/
-class Karplus_Bonus_AudioProcessor  : public juce::AudioProcessor
-{
-public:
-    //==============================================================================
-    Karplus_Bonus_AudioProcessor();
-    ~Karplus_Bonus_AudioProcessor() override;
-
-    //==============================================================================
-    void prepareToPlay (double sampleRate, int samplesPerBlock) override;
-    void releaseResources() override;
-
-   #ifndef JucePlugin_PreferredChannelConfigurations
-    bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
-   #endif
-
-    void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
-
-    //==============================================================================
-    juce::AudioProcessorEditor* createEditor() override;
-    bool hasEditor() const override;
-
-    //==============================================================================
-    const juce::String getName() const override;
-
-    bool acceptsMidi() const override;
-    bool producesMidi() const override;
-    bool isMidiEffect() const override;
-    double getTailLengthSeconds() const override;
-
-    //==============================================================================
-    int getNumPrograms() override;
-    int getCurrentProgram() override;
-    void setCurrentProgram (int index) override;
-    const juce::String getProgramName (int index) override;
-    void changeProgramName (int index, const juce::String& newName) override;
-
-    //==============================================================================
-    void getStateInformation (juce::MemoryBlock& destData) override;
-    void setStateInformation (const void* data, int sizeInBytes) override;
-    
-    // APTVS Layout
-    juce::AudioProcessorValueTreeState apvts;
-    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
-    
-    // Midi Keyboard
-    juce::MidiKeyboardState keyboardState;
-    juce::MidiKeyboardComponent keyboardComponent { keyboardState, juce::MidiKeyboardComponent::horizontalKeyboard };
-    
-
-private:
-    
-    //Source parameters
-    float NoiseGain = 0.0f;
-    juce::AudioParameterChoice * sourceParam;
-    juce::AudioParameterFloat* decayParam;
-    juce::AudioParameterFloat* widthParam;
-    juce::AudioSampleBuffer delayBuffer;
-    std::vector<std::unique_ptr<KarplusVoice>> voices; //Voices
-    juce::dsp::IIR::Filter<float> feedbackFilter;
-    juce::dsp::IIR::Coefficients<float>::Ptr feedbackCoefficients;
-    
-    //Filters Parameters
-    juce::dsp::IIR::Filter<float> globalFilter;
-    juce::dsp::IIR::Coefficients<float>::Ptr globalFilterCoefficients;
-    
-    //Tremolo variables and parameters
-    float tremoloPhase = 0.0f;
-    float tremoloRate = 5.0f;
-    float tremoloDepth = 0.5f;
-    juce::AudioParameterFloat* tremoloRateParam = nullptr;
-    juce::AudioParameterFloat* tremoloDepthParam = nullptr;
-
-    //Reverb Parameters
-    juce::Reverb reverb;
-    juce::Reverb::Parameters reverbParams;
-    juce::AudioBuffer<float> reverbBuffer;
-    juce::AudioParameterFloat* reverbMixParam = nullptr;
-    juce::AudioParameterFloat* reverbSizeParam = nullptr;
-    
-    //Output Parameters
-    juce::AudioParameterFloat* gainParam; //Gain
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Karplus_Bonus_AudioProcessor)
-};
-
-
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin processor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <juce_dsp/juce_dsp.h>
+#include "KarplusVoice.h"
+#include "DelayLinePool.h"
+#include "VoiceBank.h"
+#include "VoiceAllocator.h"
+#include "VoiceRenderPool.h"
+#include "TuningTable.h"
+#include "Biquad.h"
+#include "ExciterBank.h"
+#include "ParameterSnapshot.h"
+#include "AudioThreadGuard.h"
+#include "ControlRamp.h"
+#include "Tremolo.h"
+#include "FdnReverb.h"
+#include "PolyphaseUpsampler.h"
+#include "PresetBank.h"
+#include "Telemetry.h"
+#include "BodyResonator.h"
+#include "SympatheticBank.h"
+#include "NoteCache.h"
+#include "SharedTables.h"
+
+//==============================================================================
+/**
+*/
+class Karplus_Bonus_AudioProcessor  : public juce::AudioProcessor,
+                                      private juce::AsyncUpdater
+{
+public:
+    //==============================================================================
+    Karplus_Bonus_AudioProcessor();
+    ~Karplus_Bonus_AudioProcessor() override;
+
+    //==============================================================================
+    void prepareToPlay (double sampleRate, int samplesPerBlock) override;
+    void releaseResources() override;
+
+   #ifndef JucePlugin_PreferredChannelConfigurations
+    bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
+   #endif
+
+    void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+
+    //==============================================================================
+    juce::AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override;
+
+    //==============================================================================
+    const juce::String getName() const override;
+
+    bool acceptsMidi() const override;
+    bool producesMidi() const override;
+    bool isMidiEffect() const override;
+    double getTailLengthSeconds() const override;
+
+    //==============================================================================
+    int getNumPrograms() override;
+    int getCurrentProgram() override;
+    void setCurrentProgram (int index) override;
+    const juce::String getProgramName (int index) override;
+    void changeProgramName (int index, const juce::String& newName) override;
+
+    //==============================================================================
+    void getStateInformation (juce::MemoryBlock& destData) override;
+    void setStateInformation (const void* data, int sizeInBytes) override;
+    
+    // APTVS Layout
+    juce::AudioProcessorValueTreeState apvts;
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+    
+    // Voices on MIDI channels 1, 5, 9, 13 play through the main bus, the others can be routed to aux buses
+    static constexpr int maxOutputGroups = 4;
+
+    // Strings run at the host rate divided by 1, 2 or 4. Full keeps every voice at the host rate.
+    enum VoiceRate
+    {
+        fullRate = 0,
+        adaptiveRate
+    };
+
+    static constexpr int numRates = 3;
+
+    // What the whole chain spends per voice. Eco: averaging loop filter, adaptive rates, coarse tremolo, half the reverb lines.
+    // Standard: as set. High: every string at the host rate and oversampled excitation. Offline renders always run High.
+    enum Quality
+    {
+        eco = 0,
+        standard,
+        high
+    };
+
+    static juce::StringArray getQualityNames() { return { "Eco", "Standard", "High" }; }
+
+    const PresetBank& getPresetBank() const { return *presets; }
+
+    // Preset bank import and export, message thread only. A loaded bank replaces the current one
+    // and is saved with the plugin state. Bad data leaves the current bank in place.
+    void saveBank(juce::OutputStream& stream) const     { presets->writeTo(stream); }
+    bool loadBank(juce::InputStream& stream);
+    juce::ValueTree getBankTree() const                  { return presets->toValueTree(); }
+    bool loadBank(const juce::ValueTree& tree);
+
+    // Engine state, for the offline render tool
+    int getNumActiveVoices() const { return static_cast<int>(voiceAllocator.getActiveVoices().size()); }
+
+    // Per-block metrics, drained by one reader: the editor or the offline render tool
+    TelemetryRing& getTelemetry() { return telemetry.getRing(); }
+
+    // Notes from the editor's on-screen keyboard, merged into the incoming MIDI
+    juce::MidiKeyboardState keyboardState;
+    
+
+private:
+    // Processes a block no longer than prepareToPlay announced. Its events are read straight from the host's
+    // buffer, from midiStart on, so a long host block is split without copying its MIDI.
+    void processChunk(juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& midiMessages, int midiStart);
+    void renderVoices(int startSample, int numSamples);
+
+    // While idle nothing is smoothed, so the controls jump to their values instead of ramping from stale ones
+    void snapControls(const ParameterSnapshot& p);
+    static bool containsNoteOnOrProgramChange(juce::MidiBufferIterator first, juce::MidiBufferIterator last);
+    int chooseRateIndex(int midiNote, float filterCutoff, int voiceRate, int lowestRate) const;
+    static int getEffectiveVoiceRate(int quality, int voiceRate);
+    // Every tier but High runs its strings no faster than baseRateIndex, whatever the voice rate
+    int getLowestRateIndex(int quality) const;
+    int toRateSamples(int hostSample, int rateIndex) const;
+
+    // Reverb, dry/wet and gain for the main bus, specialised for its channel count
+    template <int numChannels>
+    void processMainOutput(juce::AudioBuffer<float>& mainBus, const float* voiceMix, const float* wetMix, const float* outputGain, int numSamples);
+    using MainOutputPath = void (Karplus_Bonus_AudioProcessor::*)(juce::AudioBuffer<float>&, const float*, const float*, const float*, int);
+    void writeOutputGroup(int group, juce::AudioBuffer<float>& buffer, const float* outputGain, int numSamples);
+
+    // Parameters, looked up once
+    CachedParameters parameters;
+
+    // Presets. A selected preset overrides the sound parameters on the audio thread
+    // until the message thread has written it into the parameters. A program change from MIDI
+    // stores the preset and posts one update, which writes it back and reports a latency change.
+    // Nothing is posted while the program and voice rates stay put.
+    void applyPreset(const Preset& preset, ParameterSnapshot& p);
+    ParameterSnapshot snapshotParameters(const PresetBank& bank);
+    void writePresetToParameters(const Preset& preset);
+    void handleAsyncUpdate() override;
+
+    // A new bank is built and prepared on the message thread, then published with one pointer swap.
+    // The audio thread marks the bank it reads for the length of each block, and the old bank
+    // is freed once no block still reads it.
+    void publishBank(std::unique_ptr<PresetBank> bank);
+    const PresetBank& holdBank();
+
+    static constexpr int stateTag = 0x504c4b53; // "PLKS"
+    static constexpr int stateVersion = 2;       // 2: followed by the bank when one was loaded
+
+    std::unique_ptr<PresetBank> presets;         // message thread
+    bool loadedBank = false;
+    std::atomic<const PresetBank*> liveBank { nullptr };
+    std::atomic<const PresetBank*> heldBank { nullptr };
+    const PresetBank* lastHeldBank = nullptr;    // audio thread only
+    std::atomic<int> currentProgram { 0 };
+    std::atomic<const Preset*> activePreset { nullptr };
+    const Preset* primedPreset = nullptr; // audio thread only
+
+    //Source parameters
+    DelayLinePool delayLines;
+    std::vector<std::unique_ptr<KarplusVoice>> voices; //Voices
+    double preparedSampleRate = 0.0; // rate the voices were built for
+    VoiceAllocator voiceAllocator;
+    VoiceBank voiceBank;
+    const DspKernels* kernels = &KernelVariants::baselineKernels;
+    VoiceRenderPool voiceRenderPool;
+    juce::SharedResourcePointer<SharedTables> sharedTables; // read-only tables, shared with every other instance
+    std::shared_ptr<const TuningTable> tuningTables[numRates];
+    ExciterBank exciterBank;
+    CoefficientCache feedbackCoefficients[numRates] { CoefficientCache { BiquadCoefficients::lowPass },
+                                                      CoefficientCache { BiquadCoefficients::lowPass },
+                                                      CoefficientCache { BiquadCoefficients::lowPass } };
+    juce::AudioBuffer<float> voiceMixBuffer; // one channel per output group
+
+    // Blocks longer than prepareToPlay announced are processed in pieces of the announced size
+    int preparedBlockSize = 0;
+
+    //Output layout, chosen in prepareToPlay
+    MainOutputPath mainOutputPath = &Karplus_Bonus_AudioProcessor::processMainOutput<2>;
+    bool multiOut = false;
+    int groupTarget[maxOutputGroups] = {}; // group a voice is mixed into, 0 when its bus is disabled
+    std::array<std::vector<KarplusVoice*>, numRates * maxOutputGroups> voiceBuckets;
+    std::array<std::vector<KarplusVoice*>, numRates * maxOutputGroups> tracedBuckets; // playing from the note cache
+
+    // Openings of repeated notes, replayed instead of synthesised
+    NoteCache noteCache;
+
+    //Voices mixed per rate and group, then upsampled into voiceMixBuffer. Full-rate voices go through
+    //a plain delay, so every rate reaches the mix with the upsamplers' latency. When every voice runs at
+    //the full rate there is nothing to line up, the delay is skipped and no latency is reported.
+    juce::AudioBuffer<float> rateMix[numRates];
+    PolyphaseUpsampler upsamplers[numRates][maxOutputGroups];
+    std::atomic<bool> ratesAligned { true };
+    int baseRateIndex = 0; // lowest rate index voices use below High quality, raised at high host rates
+    int ratePhase = 0;     // host samples processed, modulo the largest division
+    
+    //Filters Parameters
+    BiquadState globalFilter;
+    CoefficientCache globalFilterCoefficients { BiquadCoefficients::highPass };
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> lowFilterCutoff;
+    
+    //Tremolo variables and parameters
+    Tremolo tremolo;
+
+    // Undamped strings ringing along with the voices
+    SympatheticBank sympatheticStrings;
+
+    // Instrument body
+    BodyResonator bodyResonator;
+    ControlRamp bodyMix;
+
+    //Reverb Parameters
+    FdnReverb reverb;
+    ControlRamp reverbMix;
+
+    //Output Parameters
+    ControlRamp gain;
+
+    TelemetryRecorder telemetry;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Karplus_Bonus_AudioProcessor)
+};
+
+
@@ -0,0 +1,85 @@
+#include "PolyphaseUpsampler.h"
+
+void PolyphaseUpsampler::prepare(int newFactor)
+{
+    factor = juce::jmax(1, newFactor);
+    coefficients.clear();
+
+    if (factor == 1)
+    {
+        tapsPerPhase = latencySamples + 1;
+    }
+    else
+    {
+        tapsPerPhase = (prototypeLength + factor - 1) / factor;
+        const double cutoff = 0.45 / factor; // cycles per output sample, just below the input Nyquist
+
+        coefficients.assign(static_cast<size_t>(factor * tapsPerPhase), 0.0f);
+
+        for (int n = 0; n < prototypeLength; ++n)
+        {
+            const double x = n - latencySamples;
+            const double sinc = x == 0.0 ? 1.0 : std::sin(juce::MathConstants<double>::twoPi * cutoff * x) / (juce::MathConstants<double>::twoPi * cutoff * x);
+            const double window = 0.42 - 0.5 * std::cos(juce::MathConstants<double>::twoPi * (n + 0.5) / prototypeLength)
+                                       + 0.08 * std::cos(2.0 * juce::MathConstants<double>::twoPi * (n + 0.5) / prototypeLength);
+
+            // Gain of factor makes up for the zeros between input samples
+            const double h = 2.0 * cutoff * factor * sinc * window;
+
+            // Tap n belongs to phase n % factor, input n / factor samples back
+            coefficients[static_cast<size_t>((n % factor) * tapsPerPhase + n / factor)] = static_cast<float>(h);
+        }
+    }
+
+    history.assign(static_cast<size_t>(2 * tapsPerPhase), 0.0f);
+    reset();
+}
+
+void PolyphaseUpsampler::reset()
+{
+    std::fill(history.begin(), history.end(), 0.0f);
+    historyPosition = 0;
+    silentInputs = tapsPerPhase;
+}
+
+void PolyphaseUpsampler::push(float sample)
+{
+    historyPosition = historyPosition == 0 ? tapsPerPhase - 1 : historyPosition - 1;
+    history[static_cast<size_t>(historyPosition)] = history[static_cast<size_t>(historyPosition + tapsPerPhase)] = sample;
+    silentInputs = sample == 0.0f ? silentInputs + 1 : 0;
+}
+
+void PolyphaseUpsampler::process(const float* in, float* out, int numOutputs, int startPhase)
+{
+    int phase = startPhase;
+
+    for (int i = 0; i < numOutputs; ++i)
+    {
+        if (phase == 0)
+            push(*in++);
+
+        // Once the history is all zeros the output is too
+        if (silentInputs < tapsPerPhase)
+        {
+            const float* x = history.data() + historyPosition;
+
+            if (factor == 1)
+            {
+                out[i] += x[latencySamples];
+            }
+            else
+            {
+                const float* h = coefficients.data() + phase * tapsPerPhase;
+                float sum = 0.0f;
+
+                for (int tap = 0; tap < tapsPerPhase; ++tap)
+                    sum += h[tap] * x[tap];
+
+                out[i] += sum;
+            }
+        }
+
+        if (++phase == factor)
+            phase = 0;
+    }
+}
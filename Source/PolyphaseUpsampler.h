@@ -0,0 +1,34 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Integer-factor interpolator for voices rendered at a fraction of the host rate.
+// A windowed-sinc low-pass split into one short FIR per output phase, so only the taps that
+// meet real input samples are computed. The low-pass has odd length, so its delay is a whole number
+// of host samples, and it is the same for every factor. Factor 1 is a plain delay of that length,
+// so voices at every rate line up in the mix.
+class PolyphaseUpsampler
+{
+public:
+    static constexpr int latencySamples = 23;
+    static constexpr int prototypeLength = 2 * latencySamples + 1;
+
+    void prepare(int newFactor);
+    void reset();
+
+    // Delay of every factor, in host samples
+    int getLatency() const    { return latencySamples; }
+
+    // Adds numOutputs host-rate samples to out. in supplies one sample for every output at phase 0,
+    // and startPhase is the phase of the first output within its period.
+    void process(const float* in, float* out, int numOutputs, int startPhase);
+
+private:
+    void push(float sample);
+
+    int factor = 1;
+    int tapsPerPhase = latencySamples + 1;
+    std::vector<float> coefficients;  // factor rows of tapsPerPhase, empty for factor 1
+    std::vector<float> history;       // mirrored, so the newest tapsPerPhase inputs are always contiguous
+    int historyPosition = 0;
+    int silentInputs = 0;
+};
@@ -0,0 +1,230 @@
+#include "PresetBank.h"
+
+namespace
+{
+    constexpr int bankTag = 0x504c4b42; // "PLKB"
+    constexpr int bankVersion = 1;
+
+    // An empty name and an empty value list
+    constexpr int minPresetBytes = 2;
+
+    juce::uint32 hashID(const juce::String& parameterID)
+    {
+        return static_cast<juce::uint32>(parameterID.hashCode());
+    }
+
+    Preset makePreset(const juce::String& name, std::initializer_list<ParameterValue> values)
+    {
+        Preset preset;
+        preset.name = name;
+        preset.values.assign(values.begin(), values.end());
+        return preset;
+    }
+}
+
+PresetBank::PresetBank()
+{
+    // Parameters not listed keep their defaults
+    presets.push_back(makePreset("Init", {}));
+
+    presets.push_back(makePreset("Nylon Guitar", {
+        { "source", 3.0f }, { "decay", 0.98f }, { "width", 0.004f }, { "filterCutoff", 3500.0f },
+        { "lowFilterCutoff", 60.0f }, { "reverbSize", 0.35f }, { "reverbMix", 0.2f }, { "gain", 0.6f },
+        { "body", 1.0f }, { "bodyMix", 0.7f } }));
+
+    presets.push_back(makePreset("Steel Harp", {
+        { "source", 1.0f }, { "decay", 0.99f }, { "width", 0.002f }, { "filterCutoff", 8000.0f },
+        { "lowFilterCutoff", 40.0f }, { "reverbSize", 0.7f }, { "reverbMix", 0.4f },
+        { "body", 3.0f }, { "bodyMix", 0.6f }, { "sympathetic", 2.0f }, { "sympatheticLevel", 0.4f } }));
+
+    presets.push_back(makePreset("Muted Bass", {
+        { "source", 2.0f }, { "decay", 0.9f }, { "width", 0.01f }, { "filterCutoff", 600.0f },
+        { "lowFilterCutoff", 30.0f }, { "reverbSize", 0.2f }, { "reverbMix", 0.05f }, { "gain", 0.7f } }));
+
+    presets.push_back(makePreset("Koto", {
+        { "source", 0.0f }, { "decay", 0.97f }, { "width", 0.003f }, { "filterCutoff", 5000.0f },
+        { "lowFilterCutoff", 120.0f }, { "tremoloRate", 5.0f }, { "tremoloDepth", 0.1f },
+        { "reverbSize", 0.5f }, { "reverbMix", 0.3f } }));
+
+    presets.push_back(makePreset("Harpsichord", {
+        { "source", 1.0f }, { "decay", 0.96f }, { "width", 0.001f }, { "filterCutoff", 12000.0f },
+        { "lowFilterCutoff", 150.0f }, { "tuning", 1.0f }, { "reverbSize", 0.4f }, { "reverbMix", 0.25f },
+        { "body", 2.0f }, { "bodyMix", 0.5f }, { "sympathetic", 3.0f }, { "sympatheticLevel", 0.25f } }));
+
+    presets.push_back(makePreset("Dulcimer Tremolo", {
+        { "source", 3.0f }, { "decay", 0.99f }, { "width", 0.002f }, { "filterCutoff", 6000.0f },
+        { "tremoloRate", 6.5f }, { "tremoloDepth", 0.35f }, { "reverbSize", 0.6f }, { "reverbMix", 0.35f } }));
+
+    presets.push_back(makePreset("Ambient Pluck", {
+        { "source", 0.0f }, { "decay", 1.0f }, { "width", 0.015f }, { "filterCutoff", 1500.0f },
+        { "reverbSize", 0.95f }, { "reverbMix", 0.6f } }));
+}
+
+const juce::StringArray& PresetBank::getSoundParameterIDs()
+{
+    static const juce::StringArray ids { "gain", "source", "decay", "width", "filterCutoff", "tuning",
+                                         "lowFilterCutoff", "tremoloRate", "tremoloDepth", "reverbSize", "reverbMix",
+                                         "body", "bodyMix", "sympathetic", "sympatheticLevel" };
+    return ids;
+}
+
+void PresetBank::build(juce::AudioProcessorValueTreeState& apvts)
+{
+    for (auto& preset : presets)
+    {
+        std::vector<ParameterValue> complete;
+
+        for (auto& id : getSoundParameterIDs())
+        {
+            auto* parameter = apvts.getParameter(id);
+            const auto& range = parameter->getNormalisableRange();
+            float value = parameter->convertFrom0to1(parameter->getDefaultValue());
+
+            // Imported values are kept inside the parameter's range
+            for (auto& stored : preset.values)
+                if (stored.parameterID == id)
+                    value = juce::jlimit(range.start, range.end, stored.value);
+
+            complete.push_back({ id, value });
+            preset.sound.set(id, value);
+        }
+
+        preset.values = std::move(complete);
+    }
+}
+
+void PresetBank::prepare(double sampleRate, int numRates)
+{
+    for (auto& preset : presets)
+    {
+        preset.feedbackCoefficients.resize(static_cast<size_t>(numRates));
+
+        for (int rate = 0; rate < numRates; ++rate)
+            preset.feedbackCoefficients[static_cast<size_t>(rate)] = BiquadCoefficients::lowPass(sampleRate / (1 << rate), preset.sound.filterCutoff);
+    }
+}
+
+void PresetBank::writeValues(juce::OutputStream& stream, const std::vector<ParameterValue>& values)
+{
+    stream.writeCompressedInt(static_cast<int>(values.size()));
+
+    for (auto& value : values)
+    {
+        stream.writeInt(static_cast<int>(hashID(value.parameterID)));
+        stream.writeFloat(value.value);
+    }
+}
+
+std::vector<ParameterValue> PresetBank::readValues(juce::InputStream& stream, juce::AudioProcessorValueTreeState& apvts)
+{
+    std::vector<std::pair<juce::uint32, juce::String>> known;
+    for (auto* parameter : apvts.processor.getParameters())
+        if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*>(parameter))
+            known.emplace_back(hashID(withID->paramID), withID->paramID);
+
+    std::vector<ParameterValue> values;
+    const int count = stream.readCompressedInt();
+
+    for (int i = 0; i < count && ! stream.isExhausted(); ++i)
+    {
+        const auto hash = static_cast<juce::uint32>(stream.readInt());
+        const float value = stream.readFloat();
+
+        // Unknown IDs come from newer versions and are skipped
+        for (auto& [knownHash, parameterID] : known)
+            if (knownHash == hash)
+                values.push_back({ parameterID, value });
+    }
+
+    return values;
+}
+
+bool PresetBank::contains(const Preset* preset) const
+{
+    return ! presets.empty() && std::less_equal<const Preset*>()(presets.data(), preset)
+                             && std::less<const Preset*>()(preset, presets.data() + presets.size());
+}
+
+void PresetBank::writeTo(juce::OutputStream& stream) const
+{
+    stream.writeInt(bankTag);
+    stream.writeCompressedInt(bankVersion);
+    stream.writeCompressedInt(size());
+
+    for (auto& preset : presets)
+    {
+        stream.writeString(preset.name);
+        writeValues(stream, preset.values);
+    }
+}
+
+bool PresetBank::readFrom(juce::InputStream& stream, juce::AudioProcessorValueTreeState& apvts)
+{
+    if (stream.readInt() != bankTag || stream.readCompressedInt() > bankVersion)
+        return false;
+
+    // The count comes from the file, so it has to fit both the program range and the bytes that follow it
+    const int count = stream.readCompressedInt();
+    const auto remaining = stream.getNumBytesRemaining();
+
+    if (count <= 0 || count > maxPresets || (remaining >= 0 && static_cast<juce::int64>(count) * minPresetBytes > remaining))
+        return false;
+
+    std::vector<Preset> loaded(static_cast<size_t>(count));
+
+    for (auto& preset : loaded)
+    {
+        if (stream.isExhausted())
+            return false;
+
+        preset.name = stream.readString();
+        preset.values = readValues(stream, apvts);
+    }
+
+    presets = std::move(loaded);
+    return true;
+}
+
+juce::ValueTree PresetBank::toValueTree() const
+{
+    juce::ValueTree bank("PRESETS");
+
+    for (auto& preset : presets)
+    {
+        juce::ValueTree child("PRESET");
+        child.setProperty("name", preset.name, nullptr);
+
+        for (auto& value : preset.values)
+            child.setProperty(value.parameterID, value.value, nullptr);
+
+        bank.appendChild(child, nullptr);
+    }
+
+    return bank;
+}
+
+bool PresetBank::fromValueTree(const juce::ValueTree& tree)
+{
+    if (! tree.hasType("PRESETS") || tree.getNumChildren() == 0 || tree.getNumChildren() > maxPresets)
+        return false;
+
+    std::vector<Preset> loaded;
+
+    for (const auto& child : tree)
+    {
+        if (! child.hasType("PRESET"))
+            return false;
+
+        Preset preset;
+        preset.name = child.getProperty("name").toString();
+
+        for (auto& id : getSoundParameterIDs())
+            if (child.hasProperty(id))
+                preset.values.push_back({ id, static_cast<float>(child.getProperty(id)) });
+
+        loaded.push_back(std::move(preset));
+    }
+
+    presets = std::move(loaded);
+    return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <JuceHeader.h>
+#include "ParameterSnapshot.h"
+#include "Biquad.h"
+
+// Plain value of one parameter, keyed by its ID
+struct ParameterValue
+{
+    juce::String parameterID;
+    float value;
+};
+
+// One sound. Values are the parameters it sets, the rest is built ahead of time
+// on the message thread so the audio thread can switch to the preset without any work.
+struct Preset
+{
+    juce::String name;
+    std::vector<ParameterValue> values;
+    ParameterSnapshot sound {};
+    std::vector<BiquadCoefficients> feedbackCoefficients; // loop low-pass at each voice rate
+};
+
+// Factory presets plus the compact binary format used for banks and plugin state:
+// a four character tag, a version and, per preset, a name and a list of (ID hash, plain value) pairs.
+class PresetBank
+{
+public:
+    // Program change numbers reach 127
+    static constexpr int maxPresets = 128;
+
+    PresetBank();
+
+    // Parameters a preset owns, the engine settings are left alone when switching
+    static const juce::StringArray& getSoundParameterIDs();
+
+    // Completes every preset from the parameter defaults and lays it out for the audio thread
+    void build(juce::AudioProcessorValueTreeState& apvts);
+
+    // Designs the preset filters for a sample rate, voice rate r runs at sampleRate / 2^r
+    void prepare(double sampleRate, int numRates);
+
+    int size() const                                { return static_cast<int>(presets.size()); }
+    const Preset& operator[](int index) const       { return presets[static_cast<size_t>(index)]; }
+
+    // Whether preset points into this bank
+    bool contains(const Preset* preset) const;
+
+    // Import replaces the presets and leaves the bank alone when the data is bad. The bank needs build()
+    // and prepare() before the audio thread reads it, so only load into one that isn't published yet.
+    void writeTo(juce::OutputStream& stream) const;
+    bool readFrom(juce::InputStream& stream, juce::AudioProcessorValueTreeState& apvts);
+    juce::ValueTree toValueTree() const;
+    bool fromValueTree(const juce::ValueTree& tree);
+
+    // (ID hash, value) lists, IDs are resolved against the parameters of apvts
+    static void writeValues(juce::OutputStream& stream, const std::vector<ParameterValue>& values);
+    static std::vector<ParameterValue> readValues(juce::InputStream& stream, juce::AudioProcessorValueTreeState& apvts);
+
+private:
+    std::vector<Preset> presets;
+};
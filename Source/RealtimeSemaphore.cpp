@@ -0,0 +1,81 @@
+#include "RealtimeSemaphore.h"
+
+#if JUCE_WINDOWS
+ #include <windows.h>
+#elif JUCE_MAC || JUCE_IOS
+ #include <dispatch/dispatch.h>
+#else
+ #include <semaphore.h>
+ #include <cerrno>
+#endif
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+struct RealtimeSemaphore::Native
+{
+   #if JUCE_WINDOWS
+    Native()        { handle = CreateSemaphoreW(nullptr, 0, 0x7fffffff, nullptr); }
+    ~Native()       { CloseHandle(handle); }
+    void post()     { ReleaseSemaphore(handle, 1, nullptr); }
+    void wait()     { WaitForSingleObject(handle, INFINITE); }
+
+    HANDLE handle;
+   #elif JUCE_MAC || JUCE_IOS
+    Native()        { semaphore = dispatch_semaphore_create(0); }
+    ~Native()       { dispatch_release(semaphore); }
+    void post()     { dispatch_semaphore_signal(semaphore); }
+    void wait()     { dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER); }
+
+    dispatch_semaphore_t semaphore;
+   #else
+    Native()        { sem_init(&semaphore, 0, 0); }
+    ~Native()       { sem_destroy(&semaphore); }
+    void post()     { sem_post(&semaphore); }
+    void wait()     { while (sem_wait(&semaphore) != 0 && errno == EINTR) {} }
+
+    sem_t semaphore;
+   #endif
+};
+
+RealtimeSemaphore::RealtimeSemaphore() : native(std::make_unique<Native>())
+{
+}
+
+RealtimeSemaphore::~RealtimeSemaphore()
+{
+}
+
+void RealtimeSemaphore::signal()
+{
+    if (count.fetch_add(1, std::memory_order_release) < 0)
+        native->post();
+}
+
+void RealtimeSemaphore::wait()
+{
+    for (int spin = 0; spin < spinCount; ++spin)
+    {
+        int current = count.load(std::memory_order_relaxed);
+
+        if (current > 0 && count.compare_exchange_weak(current, current - 1, std::memory_order_acquire))
+            return;
+
+        pause();
+    }
+
+    if (count.fetch_sub(1, std::memory_order_acquire) <= 0)
+        native->wait();
+}
+
+void RealtimeSemaphore::pause() noexcept
+{
+   #if JUCE_INTEL
+    _mm_pause();
+   #elif JUCE_ARM && JUCE_MSVC
+    __yield();
+   #elif JUCE_ARM
+    __asm__ __volatile__ ("yield");
+   #endif
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Wakes a worker thread from the audio thread. signal() never takes a lock: it is an atomic increment, plus a
+// kernel semaphore post only when the worker has gone to sleep. wait() spins for a while before it sleeps,
+// because the audio thread usually hands out the next work within microseconds.
+class RealtimeSemaphore
+{
+public:
+    static constexpr int spinCount = 4000;
+
+    RealtimeSemaphore();
+    ~RealtimeSemaphore();
+
+    void signal();
+    void wait();
+
+    // Tells the CPU it is in a spin loop
+    static void pause() noexcept;
+
+private:
+    struct Native;
+    std::unique_ptr<Native> native;
+    std::atomic<int> count { 0 }; // below zero: a thread is asleep in the kernel semaphore
+
+    JUCE_DECLARE_NON_COPYABLE(RealtimeSemaphore)
+};
@@ -0,0 +1,33 @@
+#include "SharedTables.h"
+
+template <typename Table, typename Key, typename Build>
+std::shared_ptr<const Table> SharedTables::find(std::map<Key, std::weak_ptr<const Table>>& tables, const Key& key, Build&& build)
+{
+    const juce::ScopedLock sl(lock);
+
+    if (auto existing = tables[key].lock())
+        return existing;
+
+    // Tables nobody holds any more are dropped as new ones come in
+    for (auto it = tables.begin(); it != tables.end();)
+        it = it->second.expired() ? tables.erase(it) : std::next(it);
+
+    std::shared_ptr<const Table> table = build();
+    tables[key] = table;
+    return table;
+}
+
+std::shared_ptr<const TuningTable> SharedTables::getTuningTable(double sampleRate, int maxLoopLength)
+{
+    return find(tuningTables, std::make_pair(sampleRate, maxLoopLength), [&]
+    {
+        auto table = std::make_shared<TuningTable>();
+        table->prepare(sampleRate, maxLoopLength);
+        return table;
+    });
+}
+
+std::shared_ptr<const BodyResonator::ImpulseSet> SharedTables::getBodyImpulses(double sampleRate)
+{
+    return find(bodyImpulses, sampleRate, [&] { return BodyResonator::designImpulses(sampleRate); });
+}
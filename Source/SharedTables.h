@@ -0,0 +1,23 @@
+#pragma once
+#include <JuceHeader.h>
+#include "TuningTable.h"
+#include "BodyResonator.h"
+
+// Read-only tables that depend only on the sample rate, built once per process and shared by every
+// instance running at that rate. Instances hold a juce::SharedResourcePointer<SharedTables> and fetch
+// their tables in prepareToPlay; a table is freed when the last instance using it lets go.
+class SharedTables
+{
+public:
+    // Not real-time safe, the first caller for a rate builds the table while others wait
+    std::shared_ptr<const TuningTable> getTuningTable(double sampleRate, int maxLoopLength);
+    std::shared_ptr<const BodyResonator::ImpulseSet> getBodyImpulses(double sampleRate);
+
+private:
+    template <typename Table, typename Key, typename Build>
+    std::shared_ptr<const Table> find(std::map<Key, std::weak_ptr<const Table>>& tables, const Key& key, Build&& build);
+
+    juce::CriticalSection lock;
+    std::map<std::pair<double, int>, std::weak_ptr<const TuningTable>> tuningTables;
+    std::map<double, std::weak_ptr<const BodyResonator::ImpulseSet>> bodyImpulses;
+};
@@ -0,0 +1,324 @@
+#include "SympatheticBank.h"
+
+const juce::StringArray& SympatheticBank::getModeNames()
+{
+    static const juce::StringArray names { "Off", "12 Strings", "24 Strings", "48 Strings" };
+    return names;
+}
+
+int SympatheticBank::getNumStrings(int mode)
+{
+    switch (mode)
+    {
+        case strings12: return 12;
+        case strings24: return 24;
+        case strings48: return 48;
+        default:        return 0;
+    }
+}
+
+void SympatheticBank::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    lines.prepare(paddedStrings, DelayLinePool::getLineLength(sampleRate));
+    mask = lines.getLineLength() - 1;
+
+    // Worst case of every string on every note, so rebuilding never allocates
+    couplings.reserve(static_cast<size_t>(128 * maxStrings));
+
+    std::fill(std::begin(loopLength), std::end(loopLength), 0);
+    numStrings = 0;
+    designedTuning = nullptr;
+    reset();
+}
+
+void SympatheticBank::reset()
+{
+    for (int string = 0; string < paddedStrings; ++string)
+        juce::FloatVectorOperations::clear(lines.getLine(string), lines.getLineLength());
+
+    resetState();
+}
+
+void SympatheticBank::resetState()
+{
+    for (int string = 0; string < paddedStrings; ++string)
+    {
+        writePosition[string] = 0;
+        readPosition[string] = (0 - loopLength[string]) & mask;
+    }
+
+    for (auto* values : { state, z1, z2, coupling })
+        std::fill(values, values + paddedStrings, 0.0f);
+
+    std::fill(std::begin(quietSamples), std::end(quietSamples), 0);
+    std::fill(std::begin(awake), std::end(awake), false);
+}
+
+void SympatheticBank::buildCouplings()
+{
+    // Semitones from a fundamental to its 2nd..6th harmonics, in equal temperament
+    static constexpr int harmonicIntervals[] = { 12, 19, 24, 28, 31 };
+
+    couplings.clear();
+
+    for (int note = 0; note < 128; ++note)
+    {
+        couplingStart[note] = static_cast<int>(couplings.size());
+
+        for (int string = 0; string < numStrings; ++string)
+        {
+            const int interval = firstNote + string - note;
+
+            // A string on a harmonic of the note, or the note on a harmonic of the string
+            for (int h = 0; h < static_cast<int>(std::size(harmonicIntervals)); ++h)
+                if (interval == harmonicIntervals[h] || interval == -harmonicIntervals[h])
+                    couplings.push_back({ string, harmonicCoupling / static_cast<float>(h + 2) });
+        }
+    }
+
+    couplingStart[128] = static_cast<int>(couplings.size());
+}
+
+void SympatheticBank::setStrings(int mode, const TuningTable& tuning, int interpolation, float loopCutoff)
+{
+    const int newNumStrings = getNumStrings(mode);
+    targetCutoff = loopCutoff;
+
+    if (newNumStrings == numStrings && &tuning == designedTuning && interpolation == designedInterpolation)
+        return;
+
+    designedTuning = &tuning;
+    designedInterpolation = interpolation;
+
+    if (newNumStrings != numStrings)
+    {
+        numStrings = newNumStrings;
+        firstNote = numStrings >= 48 ? 36 : 48;
+        buildCouplings();
+
+        // Padding strings have no loop and hear nothing, so they stay silent
+        for (auto* values : { h0, h1, h2, h3, g, b0, b1, b2, a1, a2, loopGain, couplingTarget })
+            std::fill(values + numStrings, values + paddedStrings, 0.0f);
+
+        std::fill(std::begin(loopLength), std::end(loopLength), 0);
+        resetState();
+        designLoops(loopCutoff);
+
+        // On the audio thread, so only what each string reads before rewriting it is silenced, not whole lines
+        for (int string = 0; string < numStrings; ++string)
+            clearLoop(string);
+
+        return;
+    }
+
+    designLoops(loopCutoff);
+}
+
+void SympatheticBank::clearLoop(int string)
+{
+    // The taps reach three samples behind the read position, which sits a loop behind the write position
+    float* line = lines.getLine(string);
+    const int length = juce::jmin(loopLength[string] + 4, mask + 1);
+    const int start = (writePosition[string] - length) & mask;
+    const int beforeWrap = juce::jmin(length, mask + 1 - start);
+
+    juce::FloatVectorOperations::clear(line + start, beforeWrap);
+    juce::FloatVectorOperations::clear(line, length - beforeWrap);
+}
+
+void SympatheticBank::followCutoff(int numSamples)
+{
+    // Switching to or from the average filter can't be glided
+    const bool averaged = targetCutoff <= TuningTable::averageFilter;
+
+    if (averaged || designedCutoff <= TuningTable::averageFilter)
+    {
+        if (averaged != (designedCutoff <= TuningTable::averageFilter))
+            designLoops(targetCutoff);
+
+        return;
+    }
+
+    // Small moves are left alone, and a jump is spread out so each redesign moves the read taps by about a sample
+    const float octaves = std::log2(targetCutoff / designedCutoff);
+
+    if (std::abs(octaves) > retuneOctaves)
+    {
+        const float maxStep = glideOctavesPerSecond * static_cast<float>(numSamples / sampleRate);
+        designLoops(designedCutoff * std::exp2(juce::jlimit(-maxStep, maxStep, octaves)));
+    }
+}
+
+void SympatheticBank::designLoops(float loopCutoff)
+{
+    designedCutoff = loopCutoff;
+    const auto loopFilter = loopCutoff <= TuningTable::averageFilter ? BiquadCoefficients::average()
+                                                                     : BiquadCoefficients::lowPass(sampleRate, loopCutoff);
+
+    for (int string = 0; string < numStrings; ++string)
+    {
+        // Staying at the current length keeps the read tap still, the interpolator takes up the change
+        const auto loop = designedTuning->get(firstNote + string, designedInterpolation, loopCutoff, loopLength[string]);
+        h0[string] = loop.taps[0]; h1[string] = loop.taps[1];
+        h2[string] = loop.taps[2]; h3[string] = loop.taps[3];
+        g[string] = loop.feedback;
+
+        b0[string] = loopFilter.b0; b1[string] = loopFilter.b1; b2[string] = loopFilter.b2;
+        a1[string] = loopFilter.a1; a2[string] = loopFilter.a2;
+
+        if (loop.length != loopLength[string])
+        {
+            loopLength[string] = loop.length;
+            readPosition[string] = (writePosition[string] - loop.length) & mask;
+            loopGain[string] = std::pow(0.001f, static_cast<float>(loop.length) / (sustainSeconds * static_cast<float>(sampleRate)));
+        }
+    }
+}
+
+void SympatheticBank::setSoundingNotes(const std::vector<KarplusVoice*>& voices)
+{
+    std::fill(couplingTarget, couplingTarget + numStrings, baseCoupling);
+
+    for (auto* voice : voices)
+    {
+        if (voice->isFadingOut() || ! juce::isPositiveAndBelow(voice->getNoteNumber(), 128))
+            continue;
+
+        const int note = voice->getNoteNumber();
+        for (int entry = couplingStart[note]; entry < couplingStart[note + 1]; ++entry)
+            couplingTarget[couplings[static_cast<size_t>(entry)].string] += couplings[static_cast<size_t>(entry)].gain;
+    }
+}
+
+bool SympatheticBank::isAsleep() const
+{
+    for (int group = 0; group < getNumGroups(); ++group)
+        if (awake[group])
+            return false;
+
+    return true;
+}
+
+void SympatheticBank::process(float* samples, float level, int numSamples)
+{
+    if (numStrings == 0)
+        return;
+
+    for (int done = 0; done < numSamples;)
+    {
+        const int n = juce::jmin(numSamples - done, static_cast<int>(maxChunk));
+        float* out = samples + done;
+        followCutoff(n);
+
+        // The strings hear the voices only, not each other's output
+        std::copy(out, out + n, input);
+        const auto inputRange = juce::FloatVectorOperations::findMinAndMax(input, n);
+        const float inputPeak = juce::jmax(-inputRange.getStart(), inputRange.getEnd());
+
+        for (int group = 0; group < getNumGroups(); ++group)
+        {
+            const int first = group * lanes;
+            float maxCoupling = 0.0f;
+            int longestLoop = 0;
+
+            for (int string = first; string < first + lanes; ++string)
+            {
+                maxCoupling = juce::jmax(maxCoupling, coupling[string], couplingTarget[string]);
+                longestLoop = juce::jmax(longestLoop, loopLength[string]);
+            }
+
+            const bool driven = inputPeak * maxCoupling >= sleepThreshold;
+
+            if (! awake[group] && ! driven)
+                continue;
+
+            awake[group] = true;
+            const float peak = processGroup(group, input, out, level, n);
+
+            // Asleep once a whole loop has been read back below the threshold with nothing coming in
+            if (! driven && peak < sleepThreshold)
+                quietSamples[group] += n;
+            else
+                quietSamples[group] = 0;
+
+            if (quietSamples[group] > longestLoop)
+            {
+                awake[group] = false;
+                quietSamples[group] = 0;
+            }
+        }
+
+        std::copy(couplingTarget, couplingTarget + numStrings, coupling);
+        done += n;
+    }
+}
+
+float SympatheticBank::processGroup(int group, const float* in, float* out, float level, int numSamples)
+{
+    const int first = group * lanes;
+    alignas(Register::SIMDRegisterSize) float x0[lanes], x1[lanes], x2[lanes], x3[lanes], written[lanes], step[lanes];
+    float* delayData[lanes];
+
+    for (int lane = 0; lane < lanes; ++lane)
+    {
+        delayData[lane] = lines.getLine(first + lane);
+        step[lane] = (couplingTarget[first + lane] - coupling[first + lane]) / static_cast<float>(numSamples);
+    }
+
+    const auto H0 = Register::fromRawArray(h0 + first), H1 = Register::fromRawArray(h1 + first);
+    const auto H2 = Register::fromRawArray(h2 + first), H3 = Register::fromRawArray(h3 + first);
+    const auto G = Register::fromRawArray(g + first);
+    const auto B0 = Register::fromRawArray(b0 + first), B1 = Register::fromRawArray(b1 + first), B2 = Register::fromRawArray(b2 + first);
+    const auto A1 = Register::fromRawArray(a1 + first), A2 = Register::fromRawArray(a2 + first);
+    const auto LoopGain = Register::fromRawArray(loopGain + first), Step = Register::fromRawArray(step);
+    auto State = Register::fromRawArray(state + first);
+    auto Z1 = Register::fromRawArray(z1 + first), Z2 = Register::fromRawArray(z2 + first);
+    auto Coupling = Register::fromRawArray(coupling + first);
+    auto Peak = Register::expand(0.0f);
+
+    int* read = readPosition + first;
+    int* write = writePosition + first;
+
+    for (int sample = 0; sample < numSamples; ++sample)
+    {
+        for (int lane = 0; lane < lanes; ++lane)
+        {
+            const float* data = delayData[lane];
+            x0[lane] = data[read[lane]];
+            x1[lane] = data[(read[lane] - 1) & mask];
+            x2[lane] = data[(read[lane] - 2) & mask];
+            x3[lane] = data[(read[lane] - 3) & mask];
+        }
+
+        // Same loop as a voice: fractional delay, then the loop filter
+        const auto X = H0 * Register::fromRawArray(x0) + H1 * Register::fromRawArray(x1)
+                     + H2 * Register::fromRawArray(x2) + H3 * Register::fromRawArray(x3) - G * State;
+        State = X;
+
+        const auto Y = B0 * X + Z1;
+        Z1 = B1 * X - A1 * Y + Z2;
+        Z2 = B2 * X - A2 * Y;
+
+        (Coupling * in[sample] + Y * LoopGain).copyToRawArray(written);
+        Coupling += Step;
+
+        for (int lane = 0; lane < lanes; ++lane)
+        {
+            delayData[lane][write[lane]] = written[lane];
+            read[lane] = (read[lane] + 1) & mask;
+            write[lane] = (write[lane] + 1) & mask;
+        }
+
+        Peak = Register::max(Peak, Register::abs(Y));
+        out[sample] += Y.sum() * level;
+    }
+
+    State.copyToRawArray(state + first);
+    Z1.copyToRawArray(z1 + first);
+    Z2.copyToRawArray(z2 + first);
+
+    alignas(Register::SIMDRegisterSize) float peak[lanes];
+    Peak.copyToRawArray(peak);
+    return *std::max_element(peak, peak + lanes);
+}
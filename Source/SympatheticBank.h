@@ -0,0 +1,100 @@
+#pragma once
+#include <JuceHeader.h>
+#include <juce_dsp/juce_dsp.h>
+#include "DelayLinePool.h"
+#include "TuningTable.h"
+#include "Biquad.h"
+#include "KarplusVoice.h"
+
+// Undamped strings that ring along with the played ones, like a piano with the sustain pedal down.
+// Each resonator is a chromatic string loop built like a voice's, so its harmonics line up with the
+// played notes. All of them hear the voice mix weakly through the bridge. A sparse coupling matrix
+// adds a stronger feed from each sounding note to the strings a few harmonics away.
+// The strings run in SIMD groups of lanes, the last one padded out with silent strings, and a group
+// that has gone quiet is skipped entirely, so the cost is bounded by the string count and independent
+// of polyphony.
+class SympatheticBank
+{
+public:
+    using Register = juce::dsp::SIMDRegister<float>;
+    static constexpr int lanes = static_cast<int>(Register::SIMDNumElements);
+    static constexpr int maxStrings = 48;
+    static constexpr int maxGroups = (maxStrings + lanes - 1) / lanes;
+    static constexpr int paddedStrings = maxGroups * lanes;     // The last group is topped up with silent strings
+
+    static constexpr float sustainSeconds = 2.5f;      // -60 dB decay of an undriven string
+    static constexpr float baseCoupling = 0.005f;      // Every string, through the bridge
+    static constexpr float harmonicCoupling = 0.05f;   // Divided by the harmonic number
+    static constexpr float sleepThreshold = 1.0e-6f;
+    static constexpr int maxChunk = 256;
+    static constexpr float retuneOctaves = 1.0f / 96.0f;          // Cutoff change that redesigns the loops
+    static constexpr float glideOctavesPerSecond = 16.0f;         // Fastest the loops follow the cutoff
+
+    enum Mode
+    {
+        off = 0,
+        strings12,
+        strings24,
+        strings48,
+        numModes
+    };
+
+    static const juce::StringArray& getModeNames();
+    static int getNumStrings(int mode);
+
+    void prepare(double sampleRate);
+    // Clears every line, off the audio thread
+    void reset();
+
+    // Per block: the string count and the voices' loop design, so the strings stay in tune with them.
+    // The loops follow a new cutoff during process, see followCutoff.
+    void setStrings(int mode, const TuningTable& tuning, int interpolation, float loopCutoff);
+
+    // Coupling targets from the notes sounding this block, reached over the next chunk
+    void setSoundingNotes(const std::vector<KarplusVoice*>& voices);
+
+    // Adds level times the strings' output to samples, whose incoming content drives them
+    void process(float* samples, float level, int numSamples);
+
+    bool isAsleep() const;
+
+private:
+    struct Coupling
+    {
+        int string;
+        float gain;
+    };
+
+    void buildCouplings();
+    void resetState();
+    void clearLoop(int string);
+    int getNumGroups() const    { return (numStrings + lanes - 1) / lanes; }
+    void designLoops(float loopCutoff);
+    void followCutoff(int numSamples);
+    float processGroup(int group, const float* in, float* out, float level, int numSamples);
+
+    DelayLinePool lines;
+    std::vector<Coupling> couplings;           // Sparse rows, one per MIDI note
+    int couplingStart[129] = {};
+    float couplingTarget[paddedStrings] = {};
+
+    alignas(Register::SIMDRegisterSize) float h0[paddedStrings] = {}, h1[paddedStrings] = {}, h2[paddedStrings] = {}, h3[paddedStrings] = {};
+    alignas(Register::SIMDRegisterSize) float g[paddedStrings] = {}, state[paddedStrings] = {};
+    alignas(Register::SIMDRegisterSize) float b0[paddedStrings] = {}, b1[paddedStrings] = {}, b2[paddedStrings] = {};
+    alignas(Register::SIMDRegisterSize) float a1[paddedStrings] = {}, a2[paddedStrings] = {};
+    alignas(Register::SIMDRegisterSize) float z1[paddedStrings] = {}, z2[paddedStrings] = {};
+    alignas(Register::SIMDRegisterSize) float loopGain[paddedStrings] = {}, coupling[paddedStrings] = {};
+
+    int loopLength[paddedStrings] = {}, readPosition[paddedStrings] = {}, writePosition[paddedStrings] = {};
+    int quietSamples[maxGroups] = {};
+    bool awake[maxGroups] = {};
+
+    float input[maxChunk] = {};
+    double sampleRate = 44100.0;
+    int numStrings = 0, firstNote = 0, mask = 0;
+
+    // What the current loops were designed from, they are only redesigned when it changes
+    const TuningTable* designedTuning = nullptr;
+    int designedInterpolation = -1;
+    float designedCutoff = TuningTable::averageFilter, targetCutoff = TuningTable::averageFilter;
+};
@@ -0,0 +1,154 @@
+#include "Telemetry.h"
+
+const char* BlockMetrics::getStageName(int stage)
+{
+    switch (stage)
+    {
+        case midi:    return "midi";
+        case voices:  return "voices";
+        case resonance: return "resonance";
+        case body:    return "body";
+        case filters: return "filters";
+        case reverb:  return "reverb";
+        case output:  return "output";
+        default:      return "";
+    }
+}
+
+bool TelemetryRing::push(const BlockMetrics& metrics)
+{
+    const auto scope = fifo.write(1);
+
+    if (scope.blockSize1 > 0)
+        blocks[static_cast<size_t>(scope.startIndex1)] = metrics;
+    else if (scope.blockSize2 > 0)
+        blocks[static_cast<size_t>(scope.startIndex2)] = metrics;
+    else
+        return false;
+
+    return true;
+}
+
+int TelemetryRing::pop(BlockMetrics* destination, int maxBlocks)
+{
+    const auto scope = fifo.read(maxBlocks);
+
+    for (int i = 0; i < scope.blockSize1; ++i)
+        destination[i] = blocks[static_cast<size_t>(scope.startIndex1 + i)];
+
+    for (int i = 0; i < scope.blockSize2; ++i)
+        destination[scope.blockSize1 + i] = blocks[static_cast<size_t>(scope.startIndex2 + i)];
+
+    return scope.blockSize1 + scope.blockSize2;
+}
+
+#if PLUCK_TELEMETRY
+void TelemetryRecorder::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    lastTailOverruns = 0; // the body counts from its own prepare
+}
+
+void TelemetryRecorder::beginBlock(int numSamples)
+{
+    current = {};
+    current.numSamples = numSamples;
+    blockStart = now();
+}
+
+void TelemetryRecorder::addSince(BlockMetrics::Stage stage, Ticks start)
+{
+    current.stageSeconds[stage] += static_cast<float>(juce::Time::highResolutionTicksToSeconds(now() - start));
+}
+
+void TelemetryRecorder::endBlock(int activeVoices, int droppedNotesSoFar, int tailOverrunsSoFar)
+{
+    current.blockSeconds = static_cast<float>(juce::Time::highResolutionTicksToSeconds(now() - blockStart));
+    current.deadlineRatio = current.numSamples > 0 ? static_cast<float>(current.blockSeconds * sampleRate / current.numSamples) : 0.0f;
+    current.activeVoices = activeVoices;
+    current.droppedNotes = droppedNotesSoFar - lastDroppedNotes;
+    lastDroppedNotes = droppedNotesSoFar;
+    current.tailOverruns = tailOverrunsSoFar - lastTailOverruns;
+    lastTailOverruns = tailOverrunsSoFar;
+
+    ring.push(current);
+}
+#endif
+
+TelemetryStats::TelemetryStats()
+{
+    window.resize(windowSize);
+    sorted.reserve(windowSize);
+}
+
+int TelemetryStats::update(TelemetryRing& ring)
+{
+    int received = 0;
+
+    for (int count; (count = ring.pop(incoming.data(), static_cast<int>(incoming.size()))) > 0; received += count)
+        for (int i = 0; i < count; ++i)
+            add(incoming[static_cast<size_t>(i)]);
+
+    return received;
+}
+
+void TelemetryStats::reset()
+{
+    latest = {};
+    nextSlot = 0;
+    numBlocks = 0;
+    totalDroppedNotes = 0;
+    totalTailOverruns = 0;
+    totalBlocks = 0;
+}
+
+void TelemetryStats::add(const BlockMetrics& metrics)
+{
+    window[static_cast<size_t>(nextSlot)] = metrics;
+    nextSlot = (nextSlot + 1) % windowSize;
+    numBlocks = juce::jmin(numBlocks + 1, windowSize);
+
+    latest = metrics;
+    totalDroppedNotes += metrics.droppedNotes;
+    totalTailOverruns += metrics.tailOverruns;
+    ++totalBlocks;
+}
+
+float TelemetryStats::getDeadlinePercentile(float percentile) const
+{
+    if (numBlocks == 0)
+        return 0.0f;
+
+    sorted.clear();
+    for (int i = 0; i < numBlocks; ++i)
+        sorted.push_back(window[static_cast<size_t>(i)].deadlineRatio);
+
+    const auto rank = static_cast<size_t>(juce::jlimit(0, numBlocks - 1, juce::roundToInt(percentile * (numBlocks - 1))));
+    std::nth_element(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(rank), sorted.end());
+    return sorted[rank];
+}
+
+float TelemetryStats::getAverageStageSeconds(int stage) const
+{
+    if (numBlocks == 0)
+        return 0.0f;
+
+    float total = 0.0f;
+    for (int i = 0; i < numBlocks; ++i)
+        total += window[static_cast<size_t>(i)].stageSeconds[stage];
+
+    return total / numBlocks;
+}
+
+float TelemetryStats::getXrunRisk() const
+{
+    if (numBlocks == 0)
+        return 0.0f;
+
+    int risky = 0;
+    for (int i = 0; i < numBlocks; ++i)
+        if (window[static_cast<size_t>(i)].deadlineRatio > riskyDeadlineRatio)
+            ++risky;
+
+    return static_cast<float>(risky) / numBlocks;
+}
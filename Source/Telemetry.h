@@ -0,0 +1,137 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Per-block timing of processBlock. Build with PLUCK_TELEMETRY=0 to compile the
+// instrumentation out of the audio thread entirely.
+#ifndef PLUCK_TELEMETRY
+ #define PLUCK_TELEMETRY 1
+#endif
+
+// What one processBlock call cost
+struct BlockMetrics
+{
+    enum Stage
+    {
+        midi = 0,
+        voices,
+        resonance,
+        body,
+        filters,
+        reverb,
+        output,
+        numStages
+    };
+
+    float stageSeconds[numStages] = {};
+    float blockSeconds = 0.0f;
+    float deadlineRatio = 0.0f;   // Time spent over the real-time length of the block
+    int numSamples = 0;
+    int activeVoices = 0;
+    int droppedNotes = 0;
+    int tailOverruns = 0;         // Body tail blocks that came too late and played silent
+
+    static const char* getStageName(int stage);
+};
+
+// Single producer, single consumer queue of block metrics. Neither side ever waits,
+// the audio thread drops a block when the reader has fallen behind.
+class TelemetryRing
+{
+public:
+    static constexpr int capacity = 1024;
+
+    bool push(const BlockMetrics& metrics);
+    int pop(BlockMetrics* destination, int maxBlocks);
+
+private:
+    juce::AbstractFifo fifo { capacity };
+    std::array<BlockMetrics, capacity> blocks;
+};
+
+// Audio thread side: accumulates stage times for the current block and publishes it on endBlock
+class TelemetryRecorder
+{
+public:
+    using Ticks = juce::int64;
+
+    // Adds the time from construction to destruction to a stage
+    struct ScopedStage
+    {
+#if PLUCK_TELEMETRY
+        ScopedStage(TelemetryRecorder& r, BlockMetrics::Stage s) : recorder(r), stage(s), start(recorder.now()) {}
+        ~ScopedStage() { recorder.addSince(stage, start); }
+
+    private:
+        TelemetryRecorder& recorder;
+        BlockMetrics::Stage stage;
+        Ticks start;
+#else
+        ScopedStage(TelemetryRecorder&, BlockMetrics::Stage) {}
+#endif
+    };
+
+#if PLUCK_TELEMETRY
+    void prepare(double sampleRate);
+    void beginBlock(int numSamples);
+    void addSince(BlockMetrics::Stage stage, Ticks start);
+    void endBlock(int activeVoices, int droppedNotesSoFar, int tailOverrunsSoFar);
+    Ticks now() const { return juce::Time::getHighResolutionTicks(); }
+#else
+    void prepare(double) {}
+    void beginBlock(int) {}
+    void addSince(BlockMetrics::Stage, Ticks) {}
+    void endBlock(int, int, int) {}
+    Ticks now() const { return 0; }
+#endif
+
+    // Read from one thread only, the editor or the offline renderer
+    TelemetryRing& getRing() { return ring; }
+
+private:
+    TelemetryRing ring;
+
+#if PLUCK_TELEMETRY
+    BlockMetrics current;
+    Ticks blockStart = 0;
+    double sampleRate = 44100.0;
+    int lastDroppedNotes = 0;
+    int lastTailOverruns = 0;
+#endif
+};
+
+// Reader side: rolling statistics over the most recent blocks
+class TelemetryStats
+{
+public:
+    static constexpr int windowSize = 512;
+    static constexpr float riskyDeadlineRatio = 0.8f;
+
+    TelemetryStats();
+
+    // Drains the ring, returns the number of new blocks
+    int update(TelemetryRing& ring);
+    void reset();
+
+    int getNumBlocks() const { return numBlocks; }
+    float getDeadlinePercentile(float percentile) const;
+    float getAverageStageSeconds(int stage) const;
+    // Share of the window that used more than riskyDeadlineRatio of its deadline
+    float getXrunRisk() const;
+    int getActiveVoices() const { return latest.activeVoices; }
+    int getDroppedNotes() const { return totalDroppedNotes; }
+    int getTailOverruns() const { return totalTailOverruns; }
+    juce::int64 getTotalBlocks() const { return totalBlocks; }
+
+private:
+    void add(const BlockMetrics& metrics);
+
+    std::vector<BlockMetrics> window;
+    std::array<BlockMetrics, 64> incoming;
+    mutable std::vector<float> sorted;
+    BlockMetrics latest;
+    int nextSlot = 0;
+    int numBlocks = 0;
+    int totalDroppedNotes = 0;
+    int totalTailOverruns = 0;
+    juce::int64 totalBlocks = 0;
+};
@@ -0,0 +1,37 @@
+#include "TelemetryView.h"
+
+TelemetryView::TelemetryView(TelemetryRing& ringToRead)
+    : ring(ringToRead)
+{
+    setInterceptsMouseClicks(false, false);
+    startTimerHz(refreshHz);
+}
+
+void TelemetryView::timerCallback()
+{
+    // Keep draining while the host is stopped, so the ring never fills with stale blocks
+    if (stats.update(ring) == 0)
+        return;
+
+    const float xrunRisk = stats.getXrunRisk();
+    risky = xrunRisk > 0.01f || stats.getDroppedNotes() > 0 || stats.getTailOverruns() > 0;
+
+    text = "CPU p50 " + juce::String(stats.getDeadlinePercentile(0.5f) * 100.0f, 1)
+         + "%  p99 " + juce::String(stats.getDeadlinePercentile(0.99f) * 100.0f, 1)
+         + "%  max " + juce::String(stats.getDeadlinePercentile(1.0f) * 100.0f, 1)
+         + "%   voices " + juce::String(stats.getActiveVoices())
+         + "   dropped " + juce::String(stats.getDroppedNotes())
+         + "   xrun risk " + juce::String(xrunRisk * 100.0f, 1) + "%";
+
+    if (stats.getTailOverruns() > 0)
+        text << "   late body " << juce::String(stats.getTailOverruns());
+
+    repaint();
+}
+
+void TelemetryView::paint(juce::Graphics& g)
+{
+    g.setColour(risky ? juce::Colours::orangered : juce::Colours::white.withAlpha(0.6f));
+    g.setFont(juce::Font(getHeight() * 0.7f));
+    g.drawText(text, getLocalBounds(), juce::Justification::centredLeft);
+}
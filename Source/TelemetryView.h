@@ -0,0 +1,25 @@
+#pragma once
+#include <JuceHeader.h>
+#include "Telemetry.h"
+
+// One line readout of the processor's block metrics, refreshed from a timer on the message thread
+class TelemetryView : public juce::Component,
+                      private juce::Timer
+{
+public:
+    static constexpr int refreshHz = 10;
+
+    explicit TelemetryView(TelemetryRing& ringToRead);
+
+    void paint(juce::Graphics& g) override;
+
+private:
+    void timerCallback() override;
+
+    TelemetryRing& ring;
+    TelemetryStats stats;
+    juce::String text;
+    bool risky = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TelemetryView)
+};
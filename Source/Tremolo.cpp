@@ -0,0 +1,56 @@
+#include "Tremolo.h"
+
+void Tremolo::prepare(double newSampleRate, int maxBlockSize, float initialRate, float initialDepth)
+{
+    sampleRate = newSampleRate;
+
+    rate.reset(sampleRate, 0.05);
+    rate.setCurrentAndTargetValue(initialRate);
+    depth.reset(sampleRate, 0.02);
+    depth.setCurrentAndTargetValue(initialDepth);
+
+    phase = 0.0f;
+    currentGain = 1.0f - initialDepth * 0.5f;
+    gain.assign(static_cast<size_t>(juce::jmax(1, maxBlockSize)), currentGain);
+}
+
+void Tremolo::setParameters(float newRate, float newDepth)
+{
+    rate.setTargetValue(newRate);
+    depth.setTargetValue(newDepth);
+}
+
+void Tremolo::setCurrentParameters(float newRate, float newDepth)
+{
+    rate.setCurrentAndTargetValue(newRate);
+    depth.setCurrentAndTargetValue(newDepth);
+    currentGain = 1.0f - newDepth * 0.5f * (1.0f + std::sin(juce::MathConstants<float>::twoPi * phase));
+}
+
+const float* Tremolo::process(int numSamples)
+{
+    // The processor splits blocks longer than prepare announced, so this never has to grow on the audio thread
+    jassert(static_cast<size_t>(numSamples) <= gain.size());
+    numSamples = juce::jmin(numSamples, static_cast<int>(gain.size()));
+
+    float* out = gain.data();
+
+    for (int start = 0; start < numSamples; start += controlInterval)
+    {
+        const int n = juce::jmin(controlInterval, numSamples - start);
+
+        // Advance the LFO to the end of this segment
+        phase += rate.skip(n) * static_cast<float>(n) / static_cast<float>(sampleRate);
+        phase -= std::floor(phase);
+
+        const float lfo = 1.0f - depth.skip(n) * 0.5f * (1.0f + std::sin(juce::MathConstants<float>::twoPi * phase));
+        const float step = (lfo - currentGain) / static_cast<float>(n);
+
+        for (int i = 0; i < n; ++i)
+            out[start + i] = currentGain + step * static_cast<float>(i + 1);
+
+        currentGain = lfo;
+    }
+
+    return out;
+}
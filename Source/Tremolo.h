@@ -0,0 +1,26 @@
+#pragma once
+#include <JuceHeader.h>
+#include "ControlRamp.h"
+
+// Amplitude LFO rendered as a gain ramp. The sine is only evaluated every controlInterval samples.
+class Tremolo
+{
+public:
+    void prepare(double sampleRate, int maxBlockSize, float initialRate, float initialDepth);
+    void setParameters(float rate, float depth);
+
+    // Jumps to the parameters without a ramp, the gain restarts from the LFO's value at its current phase
+    void setCurrentParameters(float rate, float depth);
+    void setControlInterval(int newInterval) { controlInterval = juce::jmax(1, newInterval); }
+
+    // Fills and returns numSamples of gain, at most the maxBlockSize given to prepare
+    const float* process(int numSamples);
+
+private:
+    juce::SmoothedValue<float> rate, depth;
+    std::vector<float> gain;
+    double sampleRate = 44100.0;
+    float phase = 0.0f;
+    float currentGain = 1.0f;
+    int controlInterval = ControlRamp::defaultControlInterval;
+};
@@ -0,0 +1,174 @@
+#include "TuningTable.h"
+#include <complex>
+
+namespace
+{
+    // Phase delay of the interpolator alone, unwrapped from DC like BiquadCoefficients::getPhaseDelay. Its delay
+    // stays within a few samples, so a step every eighth of Nyquist keeps each phase increment well under pi.
+    double getInterpolatorDelay(const FractionalDelay& loop, double omega)
+    {
+        const int steps = 1 + static_cast<int>(omega * 8.0 / juce::MathConstants<double>::pi);
+        double phase = 0.0, previous = 0.0;
+
+        for (int step = 1; step <= steps; ++step)
+        {
+            const std::complex<double> z = std::polar(1.0, -omega * step / steps);
+            const auto numerator = static_cast<double>(loop.taps[0])
+                                 + z * (static_cast<double>(loop.taps[1]) + z * (static_cast<double>(loop.taps[2]) + z * static_cast<double>(loop.taps[3])));
+            const auto denominator = 1.0 + z * static_cast<double>(loop.feedback);
+            const double wrapped = std::arg(numerator / denominator);
+            phase += std::remainder(wrapped - previous, juce::MathConstants<double>::twoPi);
+            previous = wrapped;
+        }
+
+        return -phase / omega;
+    }
+
+    void setLagrangeTaps(FractionalDelay& loop, double d)
+    {
+        for (int k = 0; k < 4; ++k)
+        {
+            double h = 1.0;
+            for (int j = 0; j < 4; ++j)
+                if (j != k)
+                    h *= (d - j) / static_cast<double>(k - j);
+
+            loop.taps[k] = static_cast<float>(h);
+        }
+    }
+}
+
+double FractionalDelay::getPhaseDelay(double sampleRate, double frequency) const
+{
+    const double omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+    return length + getInterpolatorDelay(*this, omega);
+}
+
+namespace
+{
+    // Fractional delay at the start of each interpolator's table. The nominal range, a sample wide, sits in
+    // the middle: [0.6, 1.6) for the allpass, where its phase delay is flattest, and [1, 2) for Lagrange,
+    // centred over the four taps.
+    constexpr double fractionStart[] = { 0.1, 0.5 };
+}
+
+void TuningTable::prepare(double newSampleRate, int maxLoopLength)
+{
+    sampleRate = newSampleRate;
+
+    // Lagrange needs three samples behind the read tap
+    longest = static_cast<double>(maxLoopLength - 4);
+
+    for (int note = 0; note < 128; ++note)
+    {
+        const double frequency = juce::MidiMessage::getMidiNoteInHertz(note);
+        truncatedLength[note] = static_cast<int>(juce::jlimit(2.0, longest, sampleRate / frequency));
+
+        // BiquadCoefficients::lowPass is the bilinear transform of a Butterworth section, so its phase at the
+        // fundamental is the analog one at the prewarped frequency ratio. Cutoffs near Nyquist only come up at a
+        // rate the note isn't played at, they are held where the design is still valid.
+        const double omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        const double warped = std::tan(0.5 * omega);
+
+        for (int step = 0; step < numCutoffs; ++step)
+        {
+            const double cutoff = lowestCutoff * std::exp2(static_cast<double>(step) / cutoffStepsPerOctave);
+            const double x = warped / std::tan(juce::MathConstants<double>::pi * juce::jmin(cutoff, 0.45 * sampleRate) / sampleRate);
+            filterDelay[note][step] = static_cast<float>(std::atan2(juce::MathConstants<double>::sqrt2 * x, 1.0 - x * x) / omega);
+        }
+
+        for (int interpolation = 0; interpolation < truncated; ++interpolation)
+            for (int step = 0; step < numFractions; ++step)
+                fractions[note][interpolation][step] = design(note, interpolation, fractionStart[interpolation] + static_cast<double>(step) / fractionSteps);
+    }
+}
+
+FractionalDelay TuningTable::design(int midiNote, int interpolation, double fraction) const
+{
+    const double frequency = juce::MidiMessage::getMidiNoteInHertz(midiNote);
+    const double omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+    FractionalDelay loop;
+
+    // The coefficient that gives exactly this delay at the fundamental
+    if (interpolation == allpass)
+    {
+        const float c = static_cast<float>(std::sin(omega * (1.0 - fraction) * 0.5) / std::sin(omega * (1.0 + fraction) * 0.5));
+        loop.taps[0] = c;
+        loop.taps[1] = 1.0f;
+        loop.feedback = c;
+        return loop;
+    }
+
+    // Third-order Lagrange: its phase delay drifts from the design value towards Nyquist,
+    // so correct the design point a few times
+    double d = fraction;
+
+    for (int iteration = 0; iteration < 3; ++iteration)
+    {
+        setLagrangeTaps(loop, d);
+        d = juce::jlimit(0.0, 3.0, d + fraction - getInterpolatorDelay(loop, omega));
+    }
+
+    setLagrangeTaps(loop, d);
+    return loop;
+}
+
+double TuningTable::getFilterDelay(int midiNote, float loopCutoff) const
+{
+    if (loopCutoff <= averageFilter)
+        return 0.5;
+
+    const float position = juce::jlimit(0.0f, static_cast<float>(numCutoffs - 1),
+                                        std::log2(loopCutoff / lowestCutoff) * static_cast<float>(cutoffStepsPerOctave));
+    const int step = juce::jmin(static_cast<int>(position), numCutoffs - 2);
+    const float* delays = filterDelay[midiNote];
+    return delays[step] + (position - static_cast<float>(step)) * (delays[step + 1] - delays[step]);
+}
+
+FractionalDelay TuningTable::get(int midiNote, int interpolation, float loopCutoff, int preferredLength) const
+{
+    midiNote = juce::jlimit(0, 127, midiNote);
+    interpolation = juce::jlimit(0, numInterpolations - 1, interpolation);
+
+    // Truncated: the old integer loop, left uncompensated as the reference
+    if (interpolation == truncated)
+    {
+        FractionalDelay loop;
+        loop.length = truncatedLength[midiNote];
+        return loop;
+    }
+
+    // What is left of the period once the loop filter has taken its share
+    const double frequency = juce::MidiMessage::getMidiNoteInHertz(midiNote);
+    const double period = juce::jlimit(2.0, longest, sampleRate / frequency - getFilterDelay(midiNote, loopCutoff));
+
+    // The nominal length puts the fraction in the middle sample of the table
+    const double start = fractionStart[interpolation];
+    int length = static_cast<int>(period - start - 0.5);
+    double position = (period - length - start) * fractionSteps;
+
+    if (preferredLength > 0)
+    {
+        const double preferred = (period - preferredLength - start) * fractionSteps;
+
+        if (preferred >= 0.0 && preferred <= static_cast<double>(numFractions - 1))
+        {
+            length = preferredLength;
+            position = preferred;
+        }
+    }
+
+    const int step = juce::jlimit(0, numFractions - 2, static_cast<int>(position));
+    const float t = static_cast<float>(position - step);
+    const auto& a = fractions[midiNote][interpolation][step];
+    const auto& b = fractions[midiNote][interpolation][step + 1];
+
+    FractionalDelay loop;
+    loop.length = length;
+
+    for (int tap = 0; tap < 4; ++tap)
+        loop.taps[tap] = a.taps[tap] + t * (b.taps[tap] - a.taps[tap]);
+
+    loop.feedback = a.feedback + t * (b.feedback - a.feedback);
+    return loop;
+}
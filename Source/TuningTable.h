@@ -0,0 +1,61 @@
+#pragma once
+#include <JuceHeader.h>
+#include "Biquad.h"
+
+// Fractional part of a string loop, as a 4-tap FIR over the delay line plus one feedback term:
+//   y = taps[0]*x[n-L] + taps[1]*x[n-L-1] + taps[2]*x[n-L-2] + taps[3]*x[n-L-3] - feedback*y[n-1]
+// A first-order allpass uses taps {c, 1, 0, 0} and feedback c, Lagrange uses four taps and no feedback.
+struct FractionalDelay
+{
+    int length = 1;
+    float taps[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+    float feedback = 0.0f;
+
+    // Phase delay in samples at one frequency, loop length included
+    double getPhaseDelay(double sampleRate, double frequency) const;
+};
+
+// Loop lengths and interpolator coefficients for all 128 MIDI notes at one sample rate.
+// The fractional loops are tuned at each note's fundamental, including the phase delay of the loop filter.
+// Everything is designed in prepare: the loop filter's phase delay on a grid of cutoffs, and the interpolator
+// over a grid of fractional delays, so a note-on only interpolates between table entries.
+class TuningTable
+{
+public:
+    enum Interpolation
+    {
+        allpass = 0,
+        lagrange,
+        truncated,
+        numInterpolations
+    };
+
+    // Loop low-pass cutoffs are tabulated log spaced over the Acoustic Attenuator range
+    static constexpr float lowestCutoff = 20.0f;
+    static constexpr int cutoffStepsPerOctave = 24;
+    static constexpr int numCutoffs = 10 * cutoffStepsPerOctave + 1;    // Up to 20480 Hz
+
+    // Interpolators are tabulated over a span of two samples, the nominal one in the middle
+    static constexpr int fractionSteps = 32;                            // Per sample
+    static constexpr int numFractions = 2 * fractionSteps + 1;
+
+    // Cutoff that stands for the two-point average loop filter, which delays by half a sample
+    static constexpr float averageFilter = 0.0f;
+
+    void prepare(double sampleRate, int maxLoopLength);
+
+    // Loop for a string with the loop low-pass at this cutoff in it, shortened by the filter's phase delay at the
+    // fundamental. A preferred length is kept while the interpolator can still reach the note from it.
+    FractionalDelay get(int midiNote, int interpolation, float loopCutoff, int preferredLength = 0) const;
+
+    double getSampleRate() const    { return sampleRate; }
+
+private:
+    double getFilterDelay(int midiNote, float loopCutoff) const;
+    FractionalDelay design(int midiNote, int interpolation, double fraction) const;
+
+    int truncatedLength[128] = {};
+    float filterDelay[128][numCutoffs] = {};
+    FractionalDelay fractions[128][truncated][numFractions];    // Allpass and Lagrange
+    double sampleRate = 44100.0, longest = 2.0;
+};
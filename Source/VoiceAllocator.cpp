@@ -0,0 +1,149 @@
+#include "VoiceAllocator.h"
+
+void VoiceAllocator::prepare(std::vector<std::unique_ptr<KarplusVoice>>& voices)
+{
+    pool.clear();
+    for (auto& voice : voices)
+        pool.push_back(voice.get());
+
+    activeVoices.clear();
+    activeVoices.reserve(pool.size());
+    noteCounter = 0;
+
+    for (auto* voice : pool)
+        voice->startOrder = 0;
+}
+
+void VoiceAllocator::setPolyphony(int newPolyphony)
+{
+    polyphony = juce::jlimit(1, juce::jmax(1, static_cast<int>(pool.size()) - stealHeadroom), newPolyphony);
+}
+
+void VoiceAllocator::setStealMode(int newStealMode)
+{
+    stealMode = newStealMode;
+}
+
+KarplusVoice* VoiceAllocator::noteOn(int midiNote)
+{
+    if (pool.empty())
+    {
+        ++droppedNotes;
+        return nullptr;
+    }
+
+    // Re-plucking a string that is still sounding replaces it
+    int sounding = 0;
+    for (auto* voice : activeVoices)
+    {
+        if (voice->isFadingOut())
+            continue;
+
+        if (voice->getNoteNumber() == midiNote)
+            voice->fadeOut(stealFadeTime);
+        else
+            ++sounding;
+    }
+
+    if (sounding >= polyphony)
+        if (auto* victim = findVictim())
+            victim->fadeOut(stealFadeTime);
+
+    // Prefer an idle voice, otherwise cut the quietest of the fading ones short
+    KarplusVoice* chosen = nullptr;
+    for (auto* voice : pool)
+    {
+        if (!voice->isActive())
+        {
+            chosen = voice;
+            break;
+        }
+    }
+
+    if (chosen == nullptr)
+    {
+        for (auto* voice : activeVoices)
+            if (voice->isFadingOut() && (chosen == nullptr || voice->getLevel() < chosen->getLevel()))
+                chosen = voice;
+
+        if (chosen == nullptr)
+        {
+            ++droppedNotes;
+            return nullptr;
+        }
+    }
+    else
+    {
+        activeVoices.push_back(chosen);
+    }
+
+    chosen->startOrder = ++noteCounter;
+    return chosen;
+}
+
+void VoiceAllocator::noteOff(int midiNote)
+{
+    for (auto* voice : activeVoices)
+        if (voice->getNoteNumber() == midiNote && !voice->isReleased())
+            voice->stopNote();
+}
+
+void VoiceAllocator::allNotesOff()
+{
+    for (auto* voice : activeVoices)
+        if (!voice->isReleased())
+            voice->stopNote();
+}
+
+void VoiceAllocator::removeFinishedVoices()
+{
+    for (size_t i = 0; i < activeVoices.size();)
+    {
+        activeVoices[i]->endBlock();
+
+        if (activeVoices[i]->isFinished())
+        {
+            activeVoices[i]->deactivate();
+            activeVoices[i] = activeVoices.back();
+            activeVoices.pop_back();
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+KarplusVoice* VoiceAllocator::findVictim() const
+{
+    // Released strings go first, then the oldest or quietest held one
+    KarplusVoice* victim = nullptr;
+    bool victimReleased = false;
+    juce::uint32 victimOrder = 0;
+
+    for (auto* voice : activeVoices)
+    {
+        if (voice->isFadingOut())
+            continue;
+
+        const bool released = voice->isReleased();
+        const juce::uint32 order = voice->startOrder;
+
+        bool better = false;
+        if (victim == nullptr || released != victimReleased)
+            better = victim == nullptr || released;
+        else if (stealMode == stealQuietest)
+            better = voice->getLevel() < victim->getLevel();
+        else
+            better = order < victimOrder;
+
+        if (better)
+        {
+            victim = voice;
+            victimReleased = released;
+            victimOrder = order;
+        }
+    }
+
+    return victim;
+}
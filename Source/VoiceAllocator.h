@@ -0,0 +1,44 @@
+#pragma once
+#include <JuceHeader.h>
+#include "KarplusVoice.h"
+
+// Maps notes to voices, steals when the polyphony is used up and frees strings once they have decayed.
+// Only voices in the active list are ever rendered, so idle voices cost nothing.
+class VoiceAllocator
+{
+public:
+    enum StealMode
+    {
+        stealOldest = 0,
+        stealQuietest
+    };
+
+    // Spare voices on top of the polyphony, so a stolen voice can fade out while its replacement starts
+    static constexpr int stealHeadroom = 4;
+    static constexpr int maxPolyphony = 128;
+    static constexpr float stealFadeTime = 0.005f;
+
+    void prepare(std::vector<std::unique_ptr<KarplusVoice>>& voices);
+    void setPolyphony(int newPolyphony);
+    void setStealMode(int newStealMode);
+
+    KarplusVoice* noteOn(int midiNote);
+    void noteOff(int midiNote);
+    void allNotesOff();
+    // Once per host block, after the last of its voices has been rendered
+    void removeFinishedVoices();
+
+    const std::vector<KarplusVoice*>& getActiveVoices() const { return activeVoices; }
+    // Running count of note-ons that found no voice to play on
+    int getDroppedNotes() const { return droppedNotes; }
+
+private:
+    KarplusVoice* findVictim() const;
+
+    std::vector<KarplusVoice*> pool;
+    std::vector<KarplusVoice*> activeVoices;
+    juce::uint32 noteCounter = 0;
+    int polyphony = 16;
+    int stealMode = stealOldest;
+    int droppedNotes = 0;
+};
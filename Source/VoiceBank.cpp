@@ -0,0 +1,77 @@
+#include "VoiceBank.h"
+
+void VoiceBank::render(const std::vector<KarplusVoice*>& activeVoices, float* out, int numSamples)
+{
+    render(activeVoices.data(), static_cast<int>(activeVoices.size()), out, numSamples);
+}
+
+void VoiceBank::render(KarplusVoice* const* voices, int numVoices, float* out, int numSamples)
+{
+    int first = 0;
+
+    // Whole groups of voices run side by side in the SIMD lanes
+    for (; first + kernels->lanes <= numVoices; first += kernels->lanes)
+        renderGroup(*kernels, voices + first, out, numSamples);
+
+    for (; first + lanes <= numVoices; first += lanes)
+        renderGroup(KernelVariants::baselineKernels, voices + first, out, numSamples);
+
+    // Leftover voices don't fill a register
+    for (; first < numVoices; ++first)
+        voices[first]->renderBlock(out, numSamples);
+}
+
+void VoiceBank::renderGroup(const DspKernels& kernel, KarplusVoice* const* group, float* out, int numSamples)
+{
+    VoiceLanes v;
+
+    // Gather the per-voice state into lanes
+    for (int lane = 0; lane < kernel.lanes; ++lane)
+    {
+        const auto* voice = group[lane];
+        v.h0[lane] = voice->h0; v.h1[lane] = voice->h1; v.h2[lane] = voice->h2; v.h3[lane] = voice->h3;
+        v.g[lane] = voice->interpolatorFeedback;
+        v.state[lane] = voice->interpolatorState;
+
+        v.b0[lane] = voice->b0; v.b1[lane] = voice->b1; v.b2[lane] = voice->b2;
+        v.a1[lane] = voice->a1; v.a2[lane] = voice->a2;
+        v.z1[lane] = voice->z1; v.z2[lane] = voice->z2;
+        v.decay[lane] = voice->decay;
+        v.gain[lane] = voice->currentGain;
+        v.gainStep[lane] = voice->gainStep;
+
+        v.delayData[lane] = voice->delayData;
+        v.halfData[lane] = voice->halfData;
+        v.roundingError[lane] = voice->roundingError;
+        v.mask[lane] = voice->delayMask;
+        v.readPosition[lane] = voice->delayReadPosition;
+        v.writePosition[lane] = voice->delayWritePosition;
+
+        v.excitation[lane] = voice->excitation.data();
+        v.excitationPosition[lane] = voice->excitationPosition;
+        v.excitationLength[lane] = voice->excitationLength;
+    }
+
+    // Every voice of a session has the same line format
+    if (group[0]->halfData != nullptr)
+        kernel.renderHalfVoices(v, out, numSamples);
+    else
+        kernel.renderVoices(v, out, numSamples);
+
+    // Scatter the state back
+    for (int lane = 0; lane < kernel.lanes; ++lane)
+    {
+        auto* voice = group[lane];
+        voice->interpolatorState = v.state[lane];
+        voice->z1 = v.z1[lane];
+        voice->z2 = v.z2[lane];
+        voice->roundingError = v.roundingError[lane];
+        voice->delayReadPosition = v.readPosition[lane];
+        voice->delayWritePosition = v.writePosition[lane];
+        voice->excitationPosition = v.excitationPosition[lane];
+        voice->currentGain = v.gain[lane];
+        voice->blockEnergy += v.energy[lane] * static_cast<float>(numSamples);
+        voice->blockSamples += numSamples;
+        voice->holdSamples -= numSamples;
+    }
+}
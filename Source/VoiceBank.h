@@ -0,0 +1,27 @@
+#pragma once
+#include <JuceHeader.h>
+#include "KarplusVoice.h"
+#include "DspKernels.h"
+
+// Renders the active voices as a structure-of-arrays, one voice per SIMD lane.
+// Full groups go through the selected DspKernels, narrower leftovers through the baseline kernel,
+// and the remainder through KarplusVoice::renderBlock.
+class VoiceBank
+{
+public:
+    // Lanes of the baseline kernel
+    static constexpr int lanes = static_cast<int>(juce::dsp::SIMDRegister<float>::SIMDNumElements);
+
+    // Chosen once in prepareToPlay, never while rendering
+    void setKernels(const DspKernels& newKernels)    { kernels = &newKernels; }
+    const DspKernels& getKernels() const              { return *kernels; }
+    int getGroupSize() const                          { return kernels->lanes; }
+
+    void render(const std::vector<KarplusVoice*>& activeVoices, float* out, int numSamples);
+    void render(KarplusVoice* const* voices, int numVoices, float* out, int numSamples);
+
+private:
+    static void renderGroup(const DspKernels& kernel, KarplusVoice* const* group, float* out, int numSamples);
+
+    const DspKernels* kernels = &KernelVariants::baselineKernels;
+};
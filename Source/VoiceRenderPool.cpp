@@ -0,0 +1,203 @@
+#include "VoiceRenderPool.h"
+
+class VoiceRenderPool::Worker : public juce::Thread
+{
+public:
+    Worker(VoiceRenderPool& ownerPool, int index)
+        : juce::Thread("Pluck voice worker"), pool(ownerPool), workerIndex(index)
+    {
+    }
+
+    void wake() { wakeUp.signal(); }
+
+    void stop()
+    {
+        signalThreadShouldExit();
+        wakeUp.signal();
+        stopThread(1000);
+    }
+
+    void run() override
+    {
+        juce::ScopedNoDenormals noDenormals;
+
+        while (!threadShouldExit())
+        {
+            wakeUp.wait();
+
+            while (!threadShouldExit() && pool.runNextJob(workerIndex))
+            {
+            }
+        }
+    }
+
+private:
+    VoiceRenderPool& pool;
+    const int workerIndex;
+    RealtimeSemaphore wakeUp;
+};
+
+VoiceRenderPool::VoiceRenderPool()
+{
+}
+
+VoiceRenderPool::~VoiceRenderPool()
+{
+    release();
+}
+
+void VoiceRenderPool::prepare(int numThreads, int maxBlockSize, int maxLists, double sampleRate)
+{
+    // The audio thread is one of the renderers, it mixes straight into the output
+    const int numWorkers = juce::jmax(0, numThreads - 1);
+
+    // prepareToPlay never overlaps a render, so idle workers can keep running while their buses are resized
+    if (numWorkers != static_cast<int>(workers.size()))
+    {
+        release();
+
+        // Scheduled like the audio thread, falling back to the highest normal priority where that isn't allowed
+        const auto options = juce::Thread::RealtimeOptions {}.withApproximateAudioProcessingTime(maxBlockSize, sampleRate);
+
+        for (int i = 0; i < numWorkers; ++i)
+        {
+            workers.push_back(std::make_unique<Worker>(*this, i));
+
+            if (! workers.back()->startRealtimeThread(options))
+                workers.back()->startThread(juce::Thread::Priority::highest);
+        }
+    }
+
+    lists.resize(static_cast<size_t>(juce::jmax(1, maxLists)));
+    numLists = 0;
+
+    const int numBuses = numWorkers * static_cast<int>(lists.size());
+    workerBuses.setSize(juce::jmax(1, numBuses), juce::jmax(1, maxBlockSize));
+    busGeneration.assign(static_cast<size_t>(numBuses), 0);
+}
+
+void VoiceRenderPool::release()
+{
+    for (auto& worker : workers)
+        worker->stop();
+
+    workers.clear();
+}
+
+void VoiceRenderPool::clear()
+{
+    numLists = 0;
+}
+
+void VoiceRenderPool::add(const std::vector<KarplusVoice*>& voices, float* out, int numSamples)
+{
+    jassert(numLists < static_cast<int>(lists.size()));
+
+    if (voices.empty() || numSamples <= 0 || numLists >= static_cast<int>(lists.size()))
+        return;
+
+    auto& list = lists[static_cast<size_t>(numLists++)];
+    list.voices = voices.data();
+    list.numVoices = static_cast<int>(voices.size());
+    list.out = out;
+    list.numSamples = numSamples;
+}
+
+void VoiceRenderPool::render(VoiceBank& bank)
+{
+    const int groupSize = bank.getGroupSize();
+    int numVoices = 0, numJobs = 0, maxSamples = 0;
+
+    for (int i = 0; i < numLists; ++i)
+    {
+        auto& list = lists[static_cast<size_t>(i)];
+        list.firstJob = numJobs;
+        numJobs += (list.numVoices + groupSize - 1) / groupSize;
+        numVoices += list.numVoices;
+        maxSamples = juce::jmax(maxSamples, list.numSamples);
+    }
+
+    if (workers.empty() || numVoices < juce::jmax(minVoicesToSplit, 2 * groupSize) || maxSamples < minSamplesToSplit
+         || maxSamples > workerBuses.getNumSamples())
+    {
+        for (int i = 0; i < numLists; ++i)
+        {
+            const auto& list = lists[static_cast<size_t>(i)];
+            bank.render(list.voices, list.numVoices, list.out, list.numSamples);
+        }
+
+        return;
+    }
+
+    // Publish the job set, then open the cursor for this generation
+    ++generation;
+    jobBank = &bank;
+    jobGroupSize = groupSize;
+
+    const juce::uint64 tag = static_cast<juce::uint64>(generation) << 32;
+    jobsDone.store(0, std::memory_order_relaxed);
+    limit.store(tag | static_cast<juce::uint64>(numJobs), std::memory_order_release);
+    cursor.store(tag, std::memory_order_release);
+
+    for (auto& worker : workers)
+        worker->wake();
+
+    // Render alongside the workers, straight into the outputs. Any group a worker hasn't claimed yet, because it
+    // is still waking up, is rendered here, so the only wait is for groups already being rendered.
+    while (jobsDone.load(std::memory_order_acquire) < numJobs)
+        if (! runNextJob(-1))
+            RealtimeSemaphore::pause();
+
+    const int listsPerWorker = static_cast<int>(lists.size());
+
+    for (int i = 0; i < numLists; ++i)
+    {
+        const auto& list = lists[static_cast<size_t>(i)];
+
+        for (int bus = i; bus < static_cast<int>(busGeneration.size()); bus += listsPerWorker)
+            if (busGeneration[static_cast<size_t>(bus)] == generation)
+                juce::FloatVectorOperations::add(list.out, workerBuses.getReadPointer(bus), list.numSamples);
+    }
+}
+
+bool VoiceRenderPool::runNextJob(int workerIndex)
+{
+    const juce::uint64 claimed = cursor.fetch_add(1, std::memory_order_acq_rel);
+    const juce::uint64 currentLimit = limit.load(std::memory_order_acquire);
+
+    // A claim from an earlier generation, or past the last job
+    if ((claimed >> 32) != (currentLimit >> 32) || (claimed & 0xffffffffu) >= (currentLimit & 0xffffffffu))
+        return false;
+
+    const juce::uint32 jobGeneration = static_cast<juce::uint32>(claimed >> 32);
+    const int job = static_cast<int>(claimed & 0xffffffffu);
+
+    // There are only a handful of lists, one per voice rate and output bus
+    int listIndex = 0;
+    while (listIndex + 1 < numLists && job >= lists[static_cast<size_t>(listIndex + 1)].firstJob)
+        ++listIndex;
+
+    const auto& list = lists[static_cast<size_t>(listIndex)];
+    const int first = (job - list.firstJob) * jobGroupSize;
+    const int count = juce::jmin(jobGroupSize, list.numVoices - first);
+
+    // The audio thread mixes into the already cleared output, workers into their own bus for the list
+    float* out = list.out;
+
+    if (workerIndex >= 0)
+    {
+        const int bus = workerIndex * static_cast<int>(lists.size()) + listIndex;
+        out = workerBuses.getWritePointer(bus);
+
+        if (busGeneration[static_cast<size_t>(bus)] != jobGeneration)
+        {
+            juce::FloatVectorOperations::clear(out, list.numSamples);
+            busGeneration[static_cast<size_t>(bus)] = jobGeneration;
+        }
+    }
+
+    jobBank->render(list.voices + first, count, out, list.numSamples);
+
+    jobsDone.fetch_add(1, std::memory_order_acq_rel);
+    return true;
+}
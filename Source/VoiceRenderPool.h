@@ -0,0 +1,62 @@
+#pragma once
+#include <JuceHeader.h>
+#include "VoiceBank.h"
+#include "RealtimeSemaphore.h"
+
+// Spreads the active voices over pre-spawned worker threads plus the audio thread.
+// A sub-block's voice lists, one per voice rate and output bus, are added first and then rendered as one job set.
+// Work is handed out one kernel group at a time from a shared lock-free cursor, so a worker that
+// finishes early keeps taking groups until none are left, whichever list they belong to. Each worker mixes into
+// its own bus per list, and the audio thread sums the buses once every group is done. Workers run as real-time
+// threads and are woken through a RealtimeSemaphore, so handing out work never takes a lock on the audio thread.
+class VoiceRenderPool
+{
+public:
+    // Below this many active voices, or for very short sub-blocks, the audio thread renders alone
+    static constexpr int minVoicesToSplit = 4 * VoiceBank::lanes;
+    static constexpr int minSamplesToSplit = 32;
+
+    VoiceRenderPool();
+    ~VoiceRenderPool();
+
+    // Workers are only respawned when the thread count changes, otherwise only their buses are resized
+    void prepare(int numThreads, int maxBlockSize, int maxLists, double sampleRate);
+    void release();
+
+    // One fork and join per sub-block: clear, add every non-empty voice list with its output, then render them all
+    void clear();
+    void add(const std::vector<KarplusVoice*>& voices, float* out, int numSamples);
+    void render(VoiceBank& bank);
+
+private:
+    class Worker;
+
+    struct VoiceList
+    {
+        KarplusVoice* const* voices = nullptr;
+        int numVoices = 0;
+        float* out = nullptr;
+        int numSamples = 0;
+        int firstJob = 0;
+    };
+
+    bool runNextJob(int workerIndex);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    juce::AudioBuffer<float> workerBuses; // one channel per worker and list
+    std::vector<juce::uint32> busGeneration;
+
+    // Current job set, only written while no job can be claimed. Capacity is reserved in prepare.
+    std::vector<VoiceList> lists;
+    int numLists = 0;
+    VoiceBank* jobBank = nullptr;
+    int jobGroupSize = VoiceBank::lanes;
+
+    // Generation in the high 32 bits, job index or job count in the low 32 bits
+    std::atomic<juce::uint64> cursor { 0 };
+    std::atomic<juce::uint64> limit { 0 };
+    std::atomic<int> jobsDone { 0 };
+    juce::uint32 generation = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(VoiceRenderPool)
+};
@@ -0,0 +1,266 @@
+/*
+  ==============================================================================
+
+    Headless offline renderer and benchmark for the Pluck Designer engine.
+
+    Instantiates Karplus_Bonus_AudioProcessor without an editor, plays a MIDI
+    file or a synthetic chord stress pattern through it block by block, and
+    reports real-time factor, per-block time percentiles and voices per core.
+    --null=id:a:b renders the same material with a parameter at two values and
+    fails if the residual is above --limit dB, to check that an optimisation is
+    inaudible.
+    --telemetry=file.csv logs the processor's own per-stage block metrics.
+    --verify-kernels checks every DSP kernel set this CPU supports against the
+    baseline one. --verify-tuning checks every loop's pitch against its note.
+    --verify-onsets checks that notes from a MIDI file start on their exact sample.
+    --tiers benchmarks the Eco, Standard and High quality tiers.
+    --instances=N times prepareToPlay across N instances sharing their tables.
+    --restore=N times a session load: N instances restored from saved state.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "RenderHarness.h"
+
+namespace
+{
+    using namespace RenderHarness;
+
+    void printStats(const Options& options, int threads, const RenderStats& stats)
+    {
+        const double deadline = options.blockSize / options.sampleRate;
+        auto micros = [](double seconds) { return juce::String(seconds * 1.0e6, 1) + " us"; };
+        auto load = [deadline](double seconds) { return juce::String(100.0 * seconds / deadline, 1) + "%"; };
+
+        std::cout << "threads:          " << threads << "\n"
+                  << "real-time factor: " << juce::String(stats.realTimeFactor, 2) << "x\n"
+                  << "average voices:   " << juce::String(stats.averageVoices, 1) << "\n"
+                  << "voices per core:  " << juce::String(stats.averageVoices * stats.realTimeFactor / threads, 1) << "\n"
+                  << "block p50:        " << micros(stats.percentile50) << " (" << load(stats.percentile50) << " of deadline)\n"
+                  << "block p95:        " << micros(stats.percentile95) << " (" << load(stats.percentile95) << ")\n"
+                  << "block p99:        " << micros(stats.percentile99) << " (" << load(stats.percentile99) << ")\n"
+                  << "block max:        " << micros(stats.worst) << " (" << load(stats.worst) << ")\n";
+
+       #if PLUCK_TELEMETRY
+        for (int stage = 0; stage < BlockMetrics::numStages; ++stage)
+            std::cout << (juce::String("  ") + BlockMetrics::getStageName(stage) + ":").paddedRight(' ', 18)
+                      << micros(stats.stageSeconds[stage]) << " average\n";
+
+        std::cout << "dropped notes:    " << stats.droppedNotes << "\n"
+                  << "late body tails:  " << stats.tailOverruns << "\n"
+                  << "xrun risk:        " << juce::String(100.0 * stats.xrunRisk, 2) << "% of blocks over "
+                  << juce::roundToInt(100.0f * TelemetryStats::riskyDeadlineRatio) << "% of deadline\n";
+       #endif
+
+        std::cout << std::endl;
+    }
+
+    // The first instance at a rate builds the shared tables, the others only look them up
+    void timeInstances(const Options& options)
+    {
+        std::vector<std::unique_ptr<Karplus_Bonus_AudioProcessor>> processors;
+        double firstSeconds = 0.0, otherSeconds = 0.0;
+
+        for (int i = 0; i < options.instances; ++i)
+        {
+            processors.push_back(std::make_unique<Karplus_Bonus_AudioProcessor>());
+            auto& processor = *processors.back();
+            processor.setRateAndBufferSizeDetails(options.sampleRate, options.blockSize);
+
+            const auto start = juce::Time::getHighResolutionTicks();
+            processor.prepareToPlay(options.sampleRate, options.blockSize);
+            const double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+            (i == 0 ? firstSeconds : otherSeconds) += seconds;
+        }
+
+        std::cout << "instances:        " << options.instances << "\n"
+                  << "first prepare:    " << juce::String(firstSeconds * 1.0e3, 2) << " ms\n"
+                  << "later prepares:   " << juce::String(otherSeconds * 1.0e3 / juce::jmax(1, options.instances - 1), 2) << " ms average\n";
+
+        for (auto& processor : processors)
+            processor->releaseResources();
+    }
+
+    // A session load as a host runs it: each instance is constructed, restored from the same state and prepared
+    void timeRestore(const Options& options)
+    {
+        juce::MemoryBlock state;
+        {
+            Karplus_Bonus_AudioProcessor source;
+
+            for (auto& setting : options.parameterSettings)
+                setParameter(source, setting.upToFirstOccurrenceOf(":", false, false),
+                             setting.fromFirstOccurrenceOf(":", false, false).getFloatValue());
+
+            if (options.withBank)
+            {
+                juce::MemoryOutputStream bank;
+                source.saveBank(bank);
+                juce::MemoryInputStream input(bank.getData(), bank.getDataSize(), false);
+                source.loadBank(input);
+            }
+
+            source.setCurrentProgram(source.getNumPrograms() - 1);
+            source.getStateInformation(state);
+        }
+
+        std::vector<std::unique_ptr<Karplus_Bonus_AudioProcessor>> processors;
+        processors.reserve(static_cast<size_t>(options.restores));
+        double constructSeconds = 0.0, restoreSeconds = 0.0, prepareSeconds = 0.0;
+        auto seconds = [](juce::int64 from, juce::int64 to) { return juce::Time::highResolutionTicksToSeconds(to - from); };
+
+        for (int i = 0; i < options.restores; ++i)
+        {
+            const auto start = juce::Time::getHighResolutionTicks();
+            processors.push_back(std::make_unique<Karplus_Bonus_AudioProcessor>());
+            auto& processor = *processors.back();
+            const auto constructed = juce::Time::getHighResolutionTicks();
+
+            processor.setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+            const auto restored = juce::Time::getHighResolutionTicks();
+
+            processor.setRateAndBufferSizeDetails(options.sampleRate, options.blockSize);
+            processor.prepareToPlay(options.sampleRate, options.blockSize);
+            const auto prepared = juce::Time::getHighResolutionTicks();
+
+            constructSeconds += seconds(start, constructed);
+            restoreSeconds += seconds(constructed, restored);
+            prepareSeconds += seconds(restored, prepared);
+        }
+
+        const double count = juce::jmax(1, options.restores);
+        std::cout << "instances:        " << options.restores << "\n"
+                  << "state:            " << static_cast<int>(state.getSize()) << " bytes" << (options.withBank ? " with a bank" : "") << "\n"
+                  << "construct:        " << juce::String(constructSeconds * 1.0e6 / count, 1) << " us average\n"
+                  << "restore state:    " << juce::String(restoreSeconds * 1.0e6 / count, 1) << " us average\n"
+                  << "prepare:          " << juce::String(prepareSeconds * 1.0e6 / count, 1) << " us average\n"
+                  << "whole session:    " << juce::String((constructSeconds + restoreSeconds + prepareSeconds) * 1.0e3, 2) << " ms\n"
+                  << "state alone:      " << juce::String(restoreSeconds * 1.0e3, 2) << " ms" << std::endl;
+
+        for (auto& processor : processors)
+            processor->releaseResources();
+    }
+
+    bool writeWav(const juce::File& file, const juce::AudioBuffer<float>& audio, double sampleRate)
+    {
+        file.deleteFile();
+        std::unique_ptr<juce::OutputStream> stream(file.createOutputStream());
+
+        if (stream == nullptr)
+            return false;
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), sampleRate,
+                                                                            static_cast<unsigned int>(audio.getNumChannels()),
+                                                                            24, {}, 0));
+        if (writer == nullptr)
+            return false;
+
+        stream.release(); // now owned by the writer
+        return writer->writeFromAudioSampleBuffer(audio, 0, audio.getNumSamples());
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(argv[i]);
+
+    if (args.contains("--help"))
+    {
+        std::cout << "PluckRender [--midi=file.mid | --stress=notes] [--seconds=10] [--rate=48000] [--block=512]\n"
+                     "            [--threads=1] [--scaling] [--set=parameterID:value ...] [--out=render.wav]\n"
+                     "            [--null=parameterID:valueA:valueB [--limit=-60]] [--telemetry=blocks.csv] [--tiers] [--bounce]\n"
+                     "PluckRender --instances=200 [--rate=48000] [--block=512]\n"
+                     "PluckRender --restore=500 [--bank] [--set=parameterID:value ...] [--rate=48000] [--block=512]\n"
+                     "PluckRender --verify-kernels\n"
+                     "PluckRender --verify-tuning [--rate=48000]\n"
+                     "PluckRender --verify-onsets [--rate=48000] [--block=512] [--set=parameterID:value ...]\n";
+        return 0;
+    }
+
+    if (args.contains("--verify-kernels"))
+        return verifyKernels(std::cout) ? 0 : 1;
+
+    const auto options = parseOptions(args);
+
+    if (args.contains("--verify-tuning"))
+    {
+        const bool passed = verifyTuning(options, std::cout);
+        benchmarkTuning(options, std::cout);
+        return passed ? 0 : 1;
+    }
+
+    if (args.contains("--verify-onsets"))
+        return verifyOnsets(options, std::cout) ? 0 : 1;
+
+    if (options.instances > 0)
+    {
+        timeInstances(options);
+        return 0;
+    }
+
+    if (options.restores > 0)
+    {
+        timeRestore(options);
+        return 0;
+    }
+
+    double lengthSeconds = options.seconds;
+
+    const auto events = options.midiFile.isNotEmpty()
+                            ? loadMidiFile(juce::File::getCurrentWorkingDirectory().getChildFile(options.midiFile), options.sampleRate, lengthSeconds)
+                            : makeStressPattern(options.stressNotes, options.sampleRate, options.seconds);
+
+    if (options.nullSetting.isNotEmpty())
+        return verifyNull(options, events, lengthSeconds, std::cout) ? 0 : 1;
+
+    if (options.scaling)
+    {
+        // Same material on 1..N render threads
+        for (int threads = 1; threads <= juce::jmax(1, juce::SystemStats::getNumPhysicalCpus()); ++threads)
+            printStats(options, threads, render(options, threads, events, lengthSeconds, nullptr));
+
+        return 0;
+    }
+
+    if (options.tiers)
+    {
+        // Same material at each quality tier, as a real-time host would run it
+        const auto names = Karplus_Bonus_AudioProcessor::getQualityNames();
+
+        for (int tier = 0; tier < names.size(); ++tier)
+        {
+            auto settings = options;
+            settings.bounce = false;
+            settings.parameterSettings.add("quality:" + juce::String(tier));
+            std::cout << "quality:          " << names[tier] << "\n";
+            printStats(settings, options.threads, render(settings, options.threads, events, lengthSeconds, nullptr));
+        }
+
+        return 0;
+    }
+
+    juce::AudioBuffer<float> capture;
+    const auto stats = render(options, options.threads, events, lengthSeconds, options.outputFile.isNotEmpty() ? &capture : nullptr);
+    printStats(options, options.threads, stats);
+
+    if (options.outputFile.isNotEmpty())
+    {
+        const auto file = juce::File::getCurrentWorkingDirectory().getChildFile(options.outputFile);
+
+        if (!writeWav(file, capture, options.sampleRate))
+        {
+            std::cerr << "Could not write " << file.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
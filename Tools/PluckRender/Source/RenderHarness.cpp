@@ -0,0 +1,686 @@
+/*
+  ==============================================================================
+
+    Offline rendering and engine checks shared by PluckRender and PluckTests.
+
+  ==============================================================================
+*/
+
+#include "RenderHarness.h"
+#include <iostream>
+#include "../../../Source/DspKernels.h"
+#include "../../../Source/HalfFloat.h"
+
+namespace
+{
+    juce::String getOption(const juce::StringArray& args, const juce::String& name, const juce::String& fallback)
+    {
+        for (auto& arg : args)
+            if (arg.startsWith(name + "="))
+                return arg.fromFirstOccurrenceOf("=", false, false);
+
+        return fallback;
+    }
+
+    void writeTelemetryHeader(juce::OutputStream& out)
+    {
+        out << "block,samples,voices,dropped,tail_overruns,block_us,deadline_ratio";
+        for (int stage = 0; stage < BlockMetrics::numStages; ++stage)
+            out << "," << BlockMetrics::getStageName(stage) << "_us";
+        out << "\n";
+    }
+
+    void writeTelemetryLine(juce::OutputStream& out, juce::int64 index, const BlockMetrics& metrics)
+    {
+        out << juce::String(index) << "," << metrics.numSamples << "," << metrics.activeVoices << "," << metrics.droppedNotes
+            << "," << metrics.tailOverruns << "," << juce::String(metrics.blockSeconds * 1.0e6f, 2) << "," << juce::String(metrics.deadlineRatio, 4);
+        for (int stage = 0; stage < BlockMetrics::numStages; ++stage)
+            out << "," << juce::String(metrics.stageSeconds[stage] * 1.0e6f, 2);
+        out << "\n";
+    }
+
+    // Runs a kernel set over the same synthetic strings as every other set, one group of its width at a time
+    struct KernelRun
+    {
+        std::vector<float> lines, out, energy;
+        std::vector<juce::uint16> halfLines;
+    };
+
+    KernelRun runKernels(const DspKernels& kernels, int numSamples, bool halfLines = false)
+    {
+        constexpr int numVoices = VoiceLanes::maxLanes, lineLength = 1024;
+
+        KernelRun run;
+        run.lines.resize(static_cast<size_t>(numVoices * lineLength));
+        run.out.assign(static_cast<size_t>(numSamples), 0.0f);
+        run.energy.resize(static_cast<size_t>(numVoices));
+
+        juce::Random random(0x5eed);
+        for (auto& sample : run.lines)
+            sample = random.nextFloat() * 2.0f - 1.0f;
+
+        for (auto sample : run.lines)
+            run.halfLines.push_back(HalfFloat::fromFloat(sample));
+
+        std::vector<float> burst(static_cast<size_t>(numVoices * 300));
+        for (auto& sample : burst)
+            sample = random.nextFloat() - 0.5f;
+
+        for (int first = 0; first < numVoices; first += kernels.lanes)
+        {
+            VoiceLanes v {};
+
+            for (int lane = 0; lane < kernels.lanes; ++lane)
+            {
+                const int voice = first + lane;
+                const float frac = static_cast<float>(voice) / numVoices;
+
+                // Lagrange taps of a fractional delay, an allpass state and a gentle low-pass
+                v.h0[lane] = -frac * (frac - 1.0f) * (frac - 2.0f) / 6.0f;
+                v.h1[lane] = (frac + 1.0f) * (frac - 1.0f) * (frac - 2.0f) / 2.0f;
+                v.h2[lane] = -(frac + 1.0f) * frac * (frac - 2.0f) / 2.0f;
+                v.h3[lane] = (frac + 1.0f) * frac * (frac - 1.0f) / 6.0f;
+                v.g[lane] = 0.1f * frac;
+                v.b0[lane] = 0.25f;
+                v.b1[lane] = 0.5f;
+                v.b2[lane] = 0.25f;
+                v.a1[lane] = -0.2f * frac;
+                v.a2[lane] = 0.05f;
+                v.decay[lane] = 0.99f;
+                v.gain[lane] = 0.5f;
+                v.gainStep[lane] = voice % 3 == 0 ? -1.0e-4f : 0.0f;
+
+                v.delayData[lane] = run.lines.data() + voice * lineLength;
+                v.halfData[lane] = run.halfLines.data() + voice * lineLength;
+                v.mask[lane] = lineLength - 1;
+                v.writePosition[lane] = 0;
+                v.readPosition[lane] = (lineLength - 100 - 37 * voice) & (lineLength - 1);
+                v.excitation[lane] = burst.data() + voice * 300;
+                v.excitationLength[lane] = 100 + 12 * voice;
+            }
+
+            // Several calls, so state has to survive between blocks
+            const auto render = halfLines ? kernels.renderHalfVoices : kernels.renderVoices;
+
+            for (int start = 0; start < numSamples; start += 256)
+                render(v, run.out.data() + start, juce::jmin(256, numSamples - start));
+
+            for (int lane = 0; lane < kernels.lanes; ++lane)
+                run.energy[static_cast<size_t>(first + lane)] = v.energy[lane];
+        }
+
+        std::vector<float> gain(static_cast<size_t>(numSamples));
+        for (int i = 0; i < numSamples; ++i)
+            gain[static_cast<size_t>(i)] = 0.5f + 0.5f * std::sin(0.01f * static_cast<float>(i));
+
+        // Odd offsets and lengths exercise the unaligned heads and tails
+        kernels.multiply(run.out.data() + 3, gain.data() + 1, numSamples - 10);
+        return run;
+    }
+
+    // Residual in dB relative to the reference
+    double compare(const std::vector<float>& reference, const std::vector<float>& test, double& maxDifference)
+    {
+        double level = 0.0, residual = 0.0;
+        maxDifference = 0.0;
+
+        for (size_t i = 0; i < reference.size(); ++i)
+        {
+            const double difference = static_cast<double>(test[i]) - reference[i];
+            level += static_cast<double>(reference[i]) * reference[i];
+            residual += difference * difference;
+            maxDifference = juce::jmax(maxDifference, std::abs(difference));
+        }
+
+        return 10.0 * std::log10(juce::jmax(1.0e-30, residual) / juce::jmax(1.0e-30, level));
+    }
+}
+
+namespace RenderHarness
+{
+    Options parseOptions(const juce::StringArray& args)
+    {
+        Options o;
+        o.midiFile = getOption(args, "--midi", {});
+        o.outputFile = getOption(args, "--out", {});
+        o.nullSetting = getOption(args, "--null", {});
+        o.telemetryFile = getOption(args, "--telemetry", {});
+        o.sampleRate = getOption(args, "--rate", "48000").getDoubleValue();
+        o.blockSize = getOption(args, "--block", "512").getIntValue();
+        o.seconds = getOption(args, "--seconds", "10").getDoubleValue();
+        o.nullLimit = getOption(args, "--limit", "-60").getDoubleValue();
+        o.stressNotes = getOption(args, "--stress", "64").getIntValue();
+        o.threads = getOption(args, "--threads", "1").getIntValue();
+        o.instances = getOption(args, "--instances", "0").getIntValue();
+        o.restores = getOption(args, "--restore", "0").getIntValue();
+        o.withBank = args.contains("--bank");
+        o.scaling = args.contains("--scaling");
+        o.tiers = args.contains("--tiers");
+        o.bounce = args.contains("--bounce");
+
+        for (auto& arg : args)
+            if (arg.startsWith("--set="))
+                o.parameterSettings.add(arg.fromFirstOccurrenceOf("=", false, false));
+
+        return o;
+    }
+
+    void setParameter(Karplus_Bonus_AudioProcessor& processor, const juce::String& id, float value)
+    {
+        if (auto* parameter = processor.apvts.getParameter(id))
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+        else
+            std::cerr << "Unknown parameter: " << id << std::endl;
+    }
+
+    std::vector<TimedEvent> loadMidiFile(const juce::File& file, double sampleRate, double& lengthSeconds)
+    {
+        std::vector<TimedEvent> events;
+        juce::FileInputStream stream(file);
+        juce::MidiFile midi;
+
+        if (!stream.openedOk() || !midi.readFrom(stream))
+        {
+            std::cerr << "Could not read MIDI file " << file.getFullPathName() << std::endl;
+            return events;
+        }
+
+        midi.convertTimestampTicksToSeconds();
+
+        for (int track = 0; track < midi.getNumTracks(); ++track)
+        {
+            const auto* sequence = midi.getTrack(track);
+
+            for (int i = 0; i < sequence->getNumEvents(); ++i)
+            {
+                const auto& message = sequence->getEventPointer(i)->message;
+                if (message.isNoteOnOrOff() || message.isController() || message.isPitchWheel() || message.isAftertouch() || message.isChannelPressure())
+                    events.push_back({ static_cast<juce::int64>(std::llround(message.getTimeStamp() * sampleRate)), message });
+            }
+        }
+
+        std::stable_sort(events.begin(), events.end(), [](const TimedEvent& a, const TimedEvent& b) { return a.sample < b.sample; });
+
+        // Let the last notes ring out
+        lengthSeconds = midi.getLastTimestamp() + 2.0;
+        return events;
+    }
+
+    // Strummed chords across the keyboard, retriggered every half second, so the voice pool stays full
+    std::vector<TimedEvent> makeStressPattern(int numNotes, double sampleRate, double lengthSeconds)
+    {
+        std::vector<TimedEvent> events;
+        const auto chordSpacing = static_cast<juce::int64>(0.5 * sampleRate);
+        const auto strumSpacing = static_cast<juce::int64>(0.002 * sampleRate);
+        const auto length = static_cast<juce::int64>(lengthSeconds * sampleRate);
+
+        for (juce::int64 start = 0, chord = 0; start < length; start += chordSpacing, ++chord)
+        {
+            for (int i = 0; i < numNotes; ++i)
+            {
+                const int note = 28 + static_cast<int>((i * 7 + chord * 5) % 72);
+                const auto onset = start + i * strumSpacing;
+                events.push_back({ onset, juce::MidiMessage::noteOn(1, note, 0.8f) });
+                events.push_back({ onset + chordSpacing - strumSpacing, juce::MidiMessage::noteOff(1, note) });
+            }
+        }
+
+        std::stable_sort(events.begin(), events.end(), [](const TimedEvent& a, const TimedEvent& b) { return a.sample < b.sample; });
+        return events;
+    }
+
+    RenderStats render(const Options& options, int threads, const std::vector<TimedEvent>& events,
+                       double lengthSeconds, juce::AudioBuffer<float>* capture)
+    {
+        Karplus_Bonus_AudioProcessor processor;
+        processor.setNonRealtime(options.bounce);
+
+        setParameter(processor, "renderThreads", static_cast<float>(threads));
+
+        for (auto& setting : options.parameterSettings)
+            setParameter(processor, setting.upToFirstOccurrenceOf(":", false, false),
+                         setting.fromFirstOccurrenceOf(":", false, false).getFloatValue());
+
+        processor.setRateAndBufferSizeDetails(options.sampleRate, options.blockSize);
+        processor.prepareToPlay(options.sampleRate, options.blockSize);
+
+        RenderStats stats;
+        stats.latencySamples = processor.getLatencySamples();
+
+        const auto totalSamples = static_cast<juce::int64>(lengthSeconds * options.sampleRate);
+        const int numBlocks = static_cast<int>((totalSamples + options.blockSize - 1) / options.blockSize);
+
+        juce::AudioBuffer<float> block(2, options.blockSize);
+        juce::MidiBuffer midi;
+        std::vector<double> blockSeconds;
+        blockSeconds.reserve(static_cast<size_t>(numBlocks));
+
+        if (capture != nullptr)
+            capture->setSize(2, static_cast<int>(totalSamples));
+
+        std::array<BlockMetrics, 16> metrics;
+        juce::int64 numMetrics = 0, riskyBlocks = 0;
+        std::unique_ptr<juce::FileOutputStream> telemetryLog;
+
+        if (options.telemetryFile.isNotEmpty())
+        {
+            const auto file = juce::File::getCurrentWorkingDirectory().getChildFile(options.telemetryFile);
+            file.deleteFile();
+            telemetryLog = std::make_unique<juce::FileOutputStream>(file);
+            writeTelemetryHeader(*telemetryLog);
+        }
+
+        size_t nextEvent = 0;
+        double voiceSum = 0.0;
+        const auto renderStart = juce::Time::getHighResolutionTicks();
+
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            const juce::int64 blockStart = static_cast<juce::int64>(b) * options.blockSize;
+            const int numSamples = static_cast<int>(juce::jmin(static_cast<juce::int64>(options.blockSize), totalSamples - blockStart));
+
+            midi.clear();
+            while (nextEvent < events.size() && events[nextEvent].sample < blockStart + numSamples)
+            {
+                midi.addEvent(events[nextEvent].message, static_cast<int>(events[nextEvent].sample - blockStart));
+                ++nextEvent;
+            }
+
+            block.setSize(2, numSamples, false, false, true);
+
+            const auto start = juce::Time::getHighResolutionTicks();
+            processor.processBlock(block, midi);
+            blockSeconds.push_back(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start));
+
+            voiceSum += processor.getNumActiveVoices();
+
+            // Drained every block, the same way the editor does on its timer
+            for (int count; (count = processor.getTelemetry().pop(metrics.data(), static_cast<int>(metrics.size()))) > 0;)
+            {
+                for (int i = 0; i < count; ++i)
+                {
+                    const auto& m = metrics[static_cast<size_t>(i)];
+                    for (int stage = 0; stage < BlockMetrics::numStages; ++stage)
+                        stats.stageSeconds[stage] += m.stageSeconds[stage];
+
+                    stats.droppedNotes += m.droppedNotes;
+                    stats.tailOverruns += m.tailOverruns;
+                    riskyBlocks += m.deadlineRatio > TelemetryStats::riskyDeadlineRatio ? 1 : 0;
+
+                    if (telemetryLog != nullptr)
+                        writeTelemetryLine(*telemetryLog, numMetrics, m);
+
+                    ++numMetrics;
+                }
+            }
+
+            if (capture != nullptr)
+                for (int channel = 0; channel < 2; ++channel)
+                    capture->copyFrom(channel, static_cast<int>(blockStart), block, channel, 0, numSamples);
+        }
+
+        const double wallSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - renderStart);
+        processor.releaseResources();
+
+        for (auto& seconds : stats.stageSeconds)
+            seconds /= juce::jmax(static_cast<juce::int64>(1), numMetrics);
+
+        stats.xrunRisk = static_cast<double>(riskyBlocks) / juce::jmax(static_cast<juce::int64>(1), numMetrics);
+        stats.realTimeFactor = lengthSeconds / juce::jmax(1.0e-9, wallSeconds);
+        stats.averageVoices = voiceSum / juce::jmax(1, numBlocks);
+
+        std::sort(blockSeconds.begin(), blockSeconds.end());
+        auto percentile = [&blockSeconds](double p)
+        {
+            if (blockSeconds.empty())
+                return 0.0;
+
+            return blockSeconds[static_cast<size_t>(p * static_cast<double>(blockSeconds.size() - 1))];
+        };
+
+        stats.percentile50 = percentile(0.50);
+        stats.percentile95 = percentile(0.95);
+        stats.percentile99 = percentile(0.99);
+        stats.worst = percentile(1.0);
+        return stats;
+    }
+
+    // First sample, from the start, where any channel of the two renders differs
+    juce::int64 findFirstDifference(const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+    {
+        const int length = juce::jmin(a.getNumSamples(), b.getNumSamples());
+
+        for (int i = 0; i < length; ++i)
+            for (int channel = 0; channel < juce::jmin(a.getNumChannels(), b.getNumChannels()); ++channel)
+                if (a.getSample(channel, i) != b.getSample(channel, i))
+                    return i;
+
+        return -1;
+    }
+
+    // Level of b - a relative to a in dB, at the lag of b within +-maxLag samples that minimises it
+    double measureResidual(const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b, int maxLag, int& bestLag)
+    {
+        double reference = 0.0;
+        for (int channel = 0; channel < a.getNumChannels(); ++channel)
+            for (int i = 0; i < a.getNumSamples(); ++i)
+                reference += static_cast<double>(a.getSample(channel, i)) * a.getSample(channel, i);
+
+        double bestResidual = std::numeric_limits<double>::max();
+        bestLag = 0;
+
+        for (int lag = -maxLag; lag <= maxLag; ++lag)
+        {
+            double residual = 0.0;
+            for (int channel = 0; channel < a.getNumChannels(); ++channel)
+            {
+                for (int i = juce::jmax(0, -lag); i < juce::jmin(a.getNumSamples(), b.getNumSamples() - lag); ++i)
+                {
+                    const double difference = static_cast<double>(b.getSample(channel, i + lag)) - a.getSample(channel, i);
+                    residual += difference * difference;
+                }
+            }
+
+            if (residual < bestResidual)
+            {
+                bestResidual = residual;
+                bestLag = lag;
+            }
+        }
+
+        return 10.0 * std::log10(juce::jmax(1.0e-30, bestResidual) / juce::jmax(1.0e-30, reference));
+    }
+
+    // Same material with one parameter at two values, e.g. --null=voiceRate:0:1
+    bool verifyNull(const Options& options, const std::vector<TimedEvent>& events, double lengthSeconds, std::ostream& log)
+    {
+        const auto id = options.nullSetting.upToFirstOccurrenceOf(":", false, false);
+        const auto values = options.nullSetting.fromFirstOccurrenceOf(":", false, false);
+
+        auto optionsA = options, optionsB = options;
+        optionsA.parameterSettings.add(id + ":" + values.upToFirstOccurrenceOf(":", false, false));
+        optionsB.parameterSettings.add(id + ":" + values.fromFirstOccurrenceOf(":", false, false));
+
+        juce::AudioBuffer<float> a, b;
+        const int latencyA = render(optionsA, options.threads, events, lengthSeconds, &a).latencySamples;
+        const int latencyB = render(optionsB, options.threads, events, lengthSeconds, &b).latencySamples;
+
+        // A host compensates the reported latency, so any other lag is a failure too
+        int lag = 0;
+        const double residual = measureResidual(a, b, 64, lag);
+        const bool passed = residual < options.nullLimit && lag == latencyB - latencyA;
+        log << "null test " << id << " " << values << ": residual " << juce::String(residual, 1)
+            << " dB at a lag of " << lag << " samples (reported latency " << latencyA << " and " << latencyB
+            << "), limit " << juce::String(options.nullLimit, 1) << " dB" << (passed ? "" : "  FAILED") << std::endl;
+        return passed;
+    }
+
+    // Writes note-ons at awkward offsets to a MIDI file, with controllers, pitch bend and aftertouch in between,
+    // and plays it back through the file reader. A note's onset is the first sample where the render with it differs
+    // from the render without it. It has to land exactly as far after its event as the same note does after a
+    // note-on at sample 0, wherever the event falls in its block.
+    bool verifyOnsets(const Options& options, std::ostream& log)
+    {
+        constexpr int numNotes = 8;
+        juce::MidiMessageSequence track;
+        track.addEvent(juce::MidiMessage::tempoMetaEvent(500000)); // 960 ticks per quarter note: 1920 ticks per second
+
+        for (int i = 0; i < numNotes; ++i)
+        {
+            const double tick = 211.0 * i + 7.0 * (i % 3);
+            track.addEvent(juce::MidiMessage::noteOn(1, 48 + 5 * i, 0.8f), tick);
+            track.addEvent(juce::MidiMessage::controllerEvent(1, 1, 20 + i), tick + 3.0);
+            track.addEvent(juce::MidiMessage::pitchWheel(1, 8192 + 100 * i), tick + 5.0);
+            track.addEvent(juce::MidiMessage::channelPressureChange(1, 40 + i), tick + 11.0);
+        }
+
+        for (int i = 0; i < numNotes; ++i)
+            track.addEvent(juce::MidiMessage::noteOff(1, 48 + 5 * i), 211.0 * numNotes + 100.0);
+
+        track.updateMatchedPairs();
+
+        juce::MidiFile midi;
+        midi.setTicksPerQuarterNote(960);
+        midi.addTrack(track);
+
+        const auto file = juce::File::createTempFile(".mid");
+        {
+            juce::FileOutputStream stream(file);
+            midi.writeTo(stream);
+        }
+
+        double lengthSeconds = 0.0;
+        const auto events = loadMidiFile(file, options.sampleRate, lengthSeconds);
+        file.deleteFile();
+
+        std::vector<TimedEvent> noteOns;
+        for (auto& event : events)
+            if (event.message.isNoteOn())
+                noteOns.push_back(event);
+
+        if (noteOns.size() != static_cast<size_t>(numNotes))
+        {
+            log << "the MIDI file came back with " << noteOns.size() << " of " << numNotes << " note-ons  FAILED" << std::endl;
+            return false;
+        }
+
+        // A pitched source and one thread, so every render of the same events is identical
+        auto onsetOptions = options;
+        onsetOptions.parameterSettings.add("source:0");
+        onsetOptions.telemetryFile = {};
+        lengthSeconds = static_cast<double>(noteOns.back().sample) / options.sampleRate + 0.25;
+
+        // Renders with the first 0, 1, ... numNotes notes of the file
+        std::vector<juce::AudioBuffer<float>> renders(static_cast<size_t>(numNotes + 1));
+
+        for (int played = 0; played <= numNotes; ++played)
+        {
+            std::vector<TimedEvent> prefix;
+            for (auto& event : events)
+                if (played == numNotes || ! event.message.isNoteOn() || event.sample < noteOns[static_cast<size_t>(played)].sample)
+                    prefix.push_back(event);
+
+            render(onsetOptions, 1, prefix, lengthSeconds, &renders[static_cast<size_t>(played)]);
+        }
+
+        bool passed = true;
+
+        for (int i = 0; i < numNotes; ++i)
+        {
+            const auto& event = noteOns[static_cast<size_t>(i)];
+            juce::AudioBuffer<float> alone, silence;
+            render(onsetOptions, 1, { { 0, event.message } }, 0.25, &alone);
+            render(onsetOptions, 1, {}, 0.25, &silence);
+
+            const auto expected = event.sample + findFirstDifference(silence, alone);
+            const auto onset = findFirstDifference(renders[static_cast<size_t>(i)], renders[static_cast<size_t>(i + 1)]);
+            const bool ok = onset == expected;
+            passed = passed && ok;
+
+            log << "note " << event.message.getNoteNumber() << " at sample " << event.sample << " (offset "
+                << event.sample % options.blockSize << " in its block): onset " << onset << ", expected " << expected
+                << (ok ? "" : "  FAILED") << "\n";
+        }
+
+        log << std::flush;
+        return passed;
+    }
+
+    // Pitch error of every fractional loop against its note, with the loop filter's phase delay included.
+    // Truncated loops are the uncompensated reference.
+    bool verifyTuning(const Options& options, std::ostream& log)
+    {
+        const double sampleRate = options.sampleRate;
+        auto table = std::make_unique<TuningTable>();
+        table->prepare(sampleRate, 8192);
+        const auto& tuning = *table;
+
+        struct Filter
+        {
+            const char* name;
+            float cutoff;
+            BiquadCoefficients coefficients;
+        };
+
+        const Filter filters[] { { "average", TuningTable::averageFilter, BiquadCoefficients::average() },
+                                 { "low-pass 1 kHz", 1000.0f, BiquadCoefficients::lowPass(sampleRate, 1000.0f) },
+                                 { "low-pass 2 kHz", 2000.0f, BiquadCoefficients::lowPass(sampleRate, 2000.0f) },
+                                 { "low-pass 5 kHz", 5000.0f, BiquadCoefficients::lowPass(sampleRate, 5000.0f) } };
+
+        const char* names[] { "allpass", "lagrange", "truncated" };
+        constexpr double limitCents = 0.5;
+        bool passed = true;
+
+        for (int interpolation = 0; interpolation < TuningTable::numInterpolations; ++interpolation)
+        {
+            for (auto& filter : filters)
+            {
+                double worst = 0.0;
+                int worstNote = 0;
+
+                for (int note = 21; note <= 108; ++note)
+                {
+                    const double frequency = juce::MidiMessage::getMidiNoteInHertz(note);
+                    const auto loop = tuning.get(note, interpolation, filter.cutoff);
+                    const double period = loop.getPhaseDelay(sampleRate, frequency) + filter.coefficients.getPhaseDelay(sampleRate, frequency);
+                    const double cents = 1200.0 * std::log2(sampleRate / frequency / period);
+
+                    if (std::abs(cents) > std::abs(worst))
+                    {
+                        worst = cents;
+                        worstNote = note;
+                    }
+                }
+
+                const bool ok = interpolation == TuningTable::truncated || std::abs(worst) < limitCents;
+                passed = passed && ok;
+
+                log << names[interpolation] << ", " << filter.name << ": worst " << juce::String(worst, 3)
+                    << " cents at note " << worstNote << (ok ? "" : "  FAILED") << "\n";
+            }
+        }
+
+        log << std::flush;
+        return passed;
+    }
+
+    // How long the table takes to build, a note-on takes to look a loop up, and each interpolation costs per voice sample
+    void benchmarkTuning(const Options& options, std::ostream& log)
+    {
+        const double sampleRate = options.sampleRate;
+        auto table = std::make_unique<TuningTable>();
+        const auto prepareStart = juce::Time::getHighResolutionTicks();
+        table->prepare(sampleRate, 8192);
+        const double prepareSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - prepareStart);
+        const auto& tuning = *table;
+        log << "table prepared in " << juce::String(1000.0 * prepareSeconds, 1) << " ms\n";
+
+        const char* names[] { "allpass", "lagrange", "truncated" };
+
+        // A note-on only looks the loop up, so this should stay well under a microsecond
+        {
+            constexpr int lookups = 1000000;
+            std::vector<FractionalDelay> loops(88);
+            const auto start = juce::Time::getHighResolutionTicks();
+
+            for (int i = 0; i < lookups; ++i)
+                loops[static_cast<size_t>(i % 88)] = tuning.get(21 + i % 88, i % 2, 100.0f + static_cast<float>(i % 977) * 10.0f);
+
+            const double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+            log << "lookup: " << juce::String(1.0e9 * seconds / lookups, 1) << " ns per note-on\n";
+        }
+
+        // Every interpolation runs the same four tap kernel, so this should come out level
+        juce::ScopedNoDenormals noDenormals;
+        const auto& kernels = DspKernels::get(DspKernels::detectIsa());
+        constexpr int lineLength = 1024, numSamples = 48000, repeats = 20;
+        const auto filter = BiquadCoefficients::lowPass(sampleRate, 2000.0f);
+        std::vector<float> lines(static_cast<size_t>(kernels.lanes * lineLength)), out(static_cast<size_t>(numSamples));
+        juce::Random random(0x5eed);
+
+        for (int interpolation = 0; interpolation < TuningTable::numInterpolations; ++interpolation)
+        {
+            for (auto& sample : lines)
+                sample = random.nextFloat() * 2.0f - 1.0f;
+
+            VoiceLanes v {};
+
+            for (int lane = 0; lane < kernels.lanes; ++lane)
+            {
+                const auto loop = tuning.get(48 + 5 * lane, interpolation, 2000.0f);
+                v.h0[lane] = loop.taps[0];
+                v.h1[lane] = loop.taps[1];
+                v.h2[lane] = loop.taps[2];
+                v.h3[lane] = loop.taps[3];
+                v.g[lane] = loop.feedback;
+                v.b0[lane] = filter.b0;
+                v.b1[lane] = filter.b1;
+                v.b2[lane] = filter.b2;
+                v.a1[lane] = filter.a1;
+                v.a2[lane] = filter.a2;
+                v.decay[lane] = 0.999f;
+                v.gain[lane] = 0.5f;
+                v.delayData[lane] = lines.data() + lane * lineLength;
+                v.mask[lane] = lineLength - 1;
+                v.readPosition[lane] = (lineLength - loop.length) & (lineLength - 1);
+            }
+
+            const auto start = juce::Time::getHighResolutionTicks();
+
+            for (int repeat = 0; repeat < repeats; ++repeat)
+                for (int block = 0; block < numSamples; block += 256)
+                    kernels.renderVoices(v, out.data() + block, juce::jmin(256, numSamples - block));
+
+            const double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+            log << names[interpolation] << ": " << juce::String(1.0e9 * seconds / (double(repeats) * numSamples * kernels.lanes), 2)
+                << " ns per voice sample (" << kernels.name << ")\n";
+        }
+
+        log << std::flush;
+    }
+
+    bool verifyKernels(std::ostream& log)
+    {
+        constexpr int numSamples = 48000;
+        bool passed = true;
+
+        // Half float lines round differently wherever fused multiply-adds moved a value across a rounding boundary
+        for (const bool halfLines : { false, true })
+        {
+            const double limit = halfLines ? -60.0 : -90.0;
+            const auto reference = runKernels(DspKernels::get(DspKernels::baseline), numSamples, halfLines);
+
+            for (int isa = DspKernels::baseline + 1; isa < DspKernels::numIsas; ++isa)
+            {
+                if (! DspKernels::isAvailable(isa))
+                {
+                    log << "kernel set " << isa << ": not available on this CPU or build\n";
+                    continue;
+                }
+
+                const auto& kernels = DspKernels::get(isa);
+                const auto run = runKernels(kernels, numSamples, halfLines);
+
+                double maxOut = 0.0, maxEnergy = 0.0;
+                const double outResidual = compare(reference.out, run.out, maxOut);
+                const double energyResidual = compare(reference.energy, run.energy, maxEnergy);
+                const bool ok = outResidual < limit && energyResidual < limit;
+                passed = passed && ok;
+
+                log << kernels.name << (halfLines ? " half" : "") << " (" << kernels.lanes << " lanes): output residual "
+                    << juce::String(outResidual, 1) << " dB, max difference " << maxOut
+                    << ", energy residual " << juce::String(energyResidual, 1) << " dB"
+                    << (ok ? "" : "  FAILED") << "\n";
+            }
+        }
+
+        // What half float lines cost in accuracy, on the same strings
+        const auto& selected = DspKernels::get(DspKernels::detectIsa());
+        double maxHalf = 0.0;
+        const double halfResidual = compare(runKernels(selected, numSamples).out, runKernels(selected, numSamples, true).out, maxHalf);
+        log << "half lines against float: residual " << juce::String(halfResidual, 1) << " dB, max difference " << maxHalf << "\n";
+
+        log << "selected: " << DspKernels::get(DspKernels::detectIsa()).name << std::endl;
+        return passed;
+    }
+}
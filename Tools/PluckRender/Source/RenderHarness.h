@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+
+    Offline rendering and engine checks shared by PluckRender and PluckTests.
+
+    render() plays timed MIDI events through a Karplus_Bonus_AudioProcessor
+    block by block, the way a real-time host would. The checks return whether
+    they passed and write what they measured to the given stream.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <ostream>
+#include "../../../Source/PluginProcessor.h"
+
+namespace RenderHarness
+{
+    struct Options
+    {
+        juce::String midiFile, outputFile, nullSetting, telemetryFile;
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+        double seconds = 10.0;
+        double nullLimit = -60.0; // dB, the most a --null residual may reach and still pass
+        int stressNotes = 64;
+        int threads = 1;
+        int instances = 0;
+        int restores = 0;
+        bool withBank = false; // --restore: the saved state carries a loaded preset bank
+        bool scaling = false;
+        bool tiers = false;
+        bool bounce = false; // tell the processor it is an offline render, which selects High quality
+        juce::StringArray parameterSettings;
+    };
+
+    Options parseOptions(const juce::StringArray& args);
+
+    void setParameter(Karplus_Bonus_AudioProcessor& processor, const juce::String& id, float value);
+
+    // MIDI events with their absolute sample position
+    struct TimedEvent
+    {
+        juce::int64 sample;
+        juce::MidiMessage message;
+    };
+
+    std::vector<TimedEvent> loadMidiFile(const juce::File& file, double sampleRate, double& lengthSeconds);
+
+    // Strummed chords across the keyboard, retriggered every half second, so the voice pool stays full
+    std::vector<TimedEvent> makeStressPattern(int numNotes, double sampleRate, double lengthSeconds);
+
+    struct RenderStats
+    {
+        double realTimeFactor = 0.0;
+        double averageVoices = 0.0;
+        double percentile50 = 0.0, percentile95 = 0.0, percentile99 = 0.0, worst = 0.0;
+
+        // From the processor's telemetry, zero when it is compiled out
+        double stageSeconds[BlockMetrics::numStages] = {};
+        int droppedNotes = 0;
+        int tailOverruns = 0;
+        double xrunRisk = 0.0;
+        int latencySamples = 0;      // as reported to the host after prepareToPlay
+    };
+
+    // Renders lengthSeconds of the events on a fresh processor, into capture if it isn't null
+    RenderStats render(const Options& options, int threads, const std::vector<TimedEvent>& events,
+                       double lengthSeconds, juce::AudioBuffer<float>* capture);
+
+    // First sample, from the start, where any channel of the two renders differs
+    juce::int64 findFirstDifference(const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b);
+
+    // Level of b - a relative to a in dB, at the lag of b within +-maxLag samples that minimises it
+    double measureResidual(const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b, int maxLag, int& bestLag);
+
+    // Renders the events with options.nullSetting's parameter at both its values. Passes if the difference stays
+    // under options.nullLimit dB at exactly the lag the two reported latencies account for.
+    bool verifyNull(const Options& options, const std::vector<TimedEvent>& events, double lengthSeconds, std::ostream& log);
+
+    // Every note-on read from a MIDI file starts on its exact sample, wherever it falls in its block
+    bool verifyOnsets(const Options& options, std::ostream& log);
+
+    // Every allpass and Lagrange loop within half a cent of its note, with the loop filter's phase delay included
+    bool verifyTuning(const Options& options, std::ostream& log);
+
+    // Times the tuning table build, a note-on's loop lookup and the string kernel with each interpolation's taps
+    void benchmarkTuning(const Options& options, std::ostream& log);
+
+    // Every kernel set this CPU supports renders the same strings as the baseline set, within -90 dB, or -60 dB
+    // with half float lines
+    bool verifyKernels(std::ostream& log);
+}
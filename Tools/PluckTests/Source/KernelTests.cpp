@@ -0,0 +1,30 @@
+/*
+  ==============================================================================
+
+    DSP kernel sets: every instruction set this CPU and build support renders
+    the same synthetic strings as the baseline set, with float and with half
+    float delay lines.
+
+  ==============================================================================
+*/
+
+#include <sstream>
+#include "../../PluckRender/Source/RenderHarness.h"
+
+class KernelTests : public juce::UnitTest
+{
+public:
+    KernelTests() : juce::UnitTest("DSP kernels", "Engine") {}
+
+    void runTest() override
+    {
+        beginTest("Kernel sets against the baseline");
+
+        std::ostringstream log;
+        const bool passed = RenderHarness::verifyKernels(log);
+        logMessage(log.str());
+        expect(passed, "a kernel set differs from the baseline one");
+    }
+};
+
+static KernelTests kernelTests;
@@ -0,0 +1,34 @@
+/*
+  ==============================================================================
+
+    Console test runner for the Pluck Designer engine.
+
+    Runs every juce::UnitTest compiled into this target, or only those of the
+    category given as the first argument, and exits with 1 if any of them
+    failed, so a CI job or a pre-merge script can gate on it. The tests drive
+    the same render harness as PluckRender's --verify modes.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+
+    if (argc > 1)
+        runner.runTestsInCategory(argv[1]);
+    else
+        runner.runAllTests();
+
+    int failures = 0;
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        failures += runner.getResult(i)->failures;
+
+    return failures > 0 ? 1 : 0;
+}
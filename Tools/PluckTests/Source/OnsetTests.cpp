@@ -0,0 +1,37 @@
+/*
+  ==============================================================================
+
+    Sample-accurate note-ons: a note read from a MIDI file starts on its exact
+    sample wherever it falls in its block, with controllers, pitch bend and
+    aftertouch between the notes.
+
+  ==============================================================================
+*/
+
+#include <sstream>
+#include "../../PluckRender/Source/RenderHarness.h"
+
+class OnsetTests : public juce::UnitTest
+{
+public:
+    OnsetTests() : juce::UnitTest("Note onsets", "Engine") {}
+
+    void runTest() override
+    {
+        // The default block, a short one and one that doesn't divide the note spacing
+        for (const int blockSize : { 512, 64, 333 })
+        {
+            beginTest("Block size " + juce::String(blockSize));
+
+            RenderHarness::Options options;
+            options.blockSize = blockSize;
+
+            std::ostringstream log;
+            const bool passed = RenderHarness::verifyOnsets(options, log);
+            logMessage(log.str());
+            expect(passed, "a note started off its sample");
+        }
+    }
+};
+
+static OnsetTests onsetTests;
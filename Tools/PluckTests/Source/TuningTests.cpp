@@ -0,0 +1,35 @@
+/*
+  ==============================================================================
+
+    Loop tuning: every allpass and Lagrange loop stays within half a cent of
+    its note over the keyboard, with the loop filter's phase delay included.
+
+  ==============================================================================
+*/
+
+#include <sstream>
+#include "../../PluckRender/Source/RenderHarness.h"
+
+class TuningTests : public juce::UnitTest
+{
+public:
+    TuningTests() : juce::UnitTest("Loop tuning", "Engine") {}
+
+    void runTest() override
+    {
+        for (const double sampleRate : { 44100.0, 48000.0, 96000.0 })
+        {
+            beginTest(juce::String(sampleRate, 0) + " Hz");
+
+            RenderHarness::Options options;
+            options.sampleRate = sampleRate;
+
+            std::ostringstream log;
+            const bool passed = RenderHarness::verifyTuning(options, log);
+            logMessage(log.str());
+            expect(passed, "a loop is more than half a cent off its note");
+        }
+    }
+};
+
+static TuningTests tuningTests;
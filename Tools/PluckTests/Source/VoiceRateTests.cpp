@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    Adaptive voice rates: the same strummed chords with every string at the
+    host rate and with Voice Rate on Adaptive null below -60 dB, at exactly
+    the lag the difference in reported latency accounts for.
+
+    Below 88.2 kHz Full runs the strings at the host rate. From 88.2 kHz on
+    Full already runs them at the half rate, so the host-rate reference there
+    is High quality.
+
+  ==============================================================================
+*/
+
+#include <sstream>
+#include "../../PluckRender/Source/RenderHarness.h"
+
+class VoiceRateTests : public juce::UnitTest
+{
+public:
+    VoiceRateTests() : juce::UnitTest("Voice rates", "Engine") {}
+
+    void runTest() override
+    {
+        {
+            beginTest("Full against Adaptive at 48000 Hz");
+            expectNull(48000.0, "voiceRate:0:1", {});
+        }
+
+        {
+            beginTest("High against Adaptive at 96000 Hz");
+            expectNull(96000.0, "quality:2:1", "voiceRate:1");
+        }
+    }
+
+private:
+    void expectNull(double sampleRate, const juce::String& nullSetting, const juce::String& otherSetting)
+    {
+        // The noise source is seeded per voice, so the strings are plucked with a pitched one
+        RenderHarness::Options options;
+        options.sampleRate = sampleRate;
+        options.nullSetting = nullSetting;
+        options.parameterSettings.add("source:0");
+
+        if (otherSetting.isNotEmpty())
+            options.parameterSettings.add(otherSetting);
+
+        constexpr double lengthSeconds = 3.0;
+        const auto events = RenderHarness::makeStressPattern(16, sampleRate, lengthSeconds);
+
+        std::ostringstream log;
+        const bool passed = RenderHarness::verifyNull(options, events, lengthSeconds, log);
+        logMessage(log.str());
+        expect(passed, "Adaptive doesn't null against strings at the host rate");
+    }
+};
+
+static VoiceRateTests voiceRateTests;